@@ -20,7 +20,7 @@
 #include <Adafruit_BMP280.h>
 #endif
 
-extern Ticker bmecycler;
+extern JobTimer bmecycler;
 
 extern bmeStatus_t
     bme_status; // Make struct for storing gps data globally available
@@ -2,6 +2,8 @@
 #define _BUTTON_H
 
 #include <OneButton.h>
+#include <driver/gpio.h>
+#include <esp_sleep.h>
 #include "irqhandler.h"
 #include "senddata.h"
 #include "display.h"
@@ -19,5 +21,6 @@ extern TaskHandle_t buttonLoopTask;
 
 void button_init(void);
 void readButton(void);
+void IRAM_ATTR ButtonIRQ(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef _CALENDAR_H
+#define _CALENDAR_H
+
+#include <stdint.h>
+#include <time.h>
+
+/* calendar arithmetic in constant time
+
+days_from_civil() and civil_from_days() convert between proleptic gregorian
+dates and days since 1970-01-01, based on the algorithms of Howard Hinnant,
+http://howardhinnant.github.io/date_algorithms.html
+
+Local time follows a POSIX TZ rule string. Offset and DST state are cached
+until the next DST transition, so localtime costs one division per call.
+*/
+
+#define SECS_PER_DAY 86400L
+
+// --- constexpr helpers, written as single expressions for C++11 ---
+
+constexpr int32_t cal_era(int32_t y) { return (y >= 0 ? y : y - 399) / 400; }
+
+constexpr int32_t cal_doy(uint32_t m, uint32_t d) {
+  return (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+}
+
+constexpr int32_t cal_doe(int32_t yoe, int32_t doy) {
+  return yoe * 365 + yoe / 4 - yoe / 100 + doy;
+}
+
+constexpr int32_t cal_days(int32_t y, uint32_t m, uint32_t d) {
+  return cal_era(y) * 146097 + cal_doe(y - cal_era(y) * 400, cal_doy(m, d)) -
+         719468;
+}
+
+// days since 1970-01-01 of date y-m-d, month 1..12, day 1..31
+constexpr int32_t days_from_civil(int32_t y, uint32_t m, uint32_t d) {
+  return cal_days(y - (m <= 2), m, d);
+}
+
+// day of week of days since 1970-01-01, 0 = sunday
+constexpr uint32_t weekday_from_days(int32_t z) {
+  return z >= -4 ? (z + 4) % 7 : (z + 5) % 7 + 6;
+}
+
+constexpr bool is_leap(int32_t y) {
+  return (y % 4 == 0) && ((y % 100 != 0) || (y % 400 == 0));
+}
+
+constexpr uint32_t last_day_of_month(int32_t y, uint32_t m) {
+  return (m != 2) ? ((m == 4 || m == 6 || m == 9 || m == 11) ? 30 : 31)
+                  : (is_leap(y) ? 29 : 28);
+}
+
+// --- build time from __DATE__ "Mmm dd yyyy" and __TIME__ "hh:mm:ss" ---
+
+constexpr uint32_t cal_digit(char c) { return c == ' ' ? 0 : c - '0'; }
+
+constexpr uint32_t cal_month(const char *s) {
+  return s[0] == 'J'   ? (s[1] == 'a' ? 1 : (s[2] == 'n' ? 6 : 7))
+         : s[0] == 'F' ? 2
+         : s[0] == 'M' ? (s[2] == 'r' ? 3 : 5)
+         : s[0] == 'A' ? (s[1] == 'p' ? 4 : 8)
+         : s[0] == 'S' ? 9
+         : s[0] == 'O' ? 10
+         : s[0] == 'N' ? 11
+                       : 12;
+}
+
+// build time, as if build machine's local time was UTC
+constexpr time_t CAL_BUILD_TIME =
+    (time_t)days_from_civil(
+        cal_digit(__DATE__[7]) * 1000 + cal_digit(__DATE__[8]) * 100 +
+            cal_digit(__DATE__[9]) * 10 + cal_digit(__DATE__[10]),
+        cal_month(__DATE__),
+        cal_digit(__DATE__[4]) * 10 + cal_digit(__DATE__[5])) *
+        SECS_PER_DAY +
+    (cal_digit(__TIME__[0]) * 10 + cal_digit(__TIME__[1])) * 3600 +
+    (cal_digit(__TIME__[3]) * 10 + cal_digit(__TIME__[4])) * 60 +
+    cal_digit(__TIME__[6]) * 10 + cal_digit(__TIME__[7]);
+
+// --- conversions ---
+
+extern const char cal_wday_names[7][4];
+extern const char cal_month_names[12][4];
+
+void civil_from_days(int32_t z, int32_t *y, uint32_t *m, uint32_t *d);
+time_t cal_mkgmtime(const struct tm *tm);
+void cal_gmtime(time_t t, struct tm *tm);
+
+// --- local time ---
+
+bool cal_settz(const char *tz);
+int32_t cal_utcoffset(time_t t, bool *isdst = NULL);
+void cal_localtime(time_t t, struct tm *tm);
+
+#endif
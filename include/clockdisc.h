@@ -0,0 +1,32 @@
+#ifndef _CLOCKDISC_H
+#define _CLOCKDISC_H
+
+#include "globals.h"
+#include "timekeeper.h"
+
+#ifndef TIME_SYNC_INTERVAL_MAX
+#define TIME_SYNC_INTERVAL_MAX TIME_SYNC_INTERVAL
+#endif
+#ifndef TIME_SYNC_TOLERANCE
+#define TIME_SYNC_TOLERANCE 100
+#endif
+#ifndef TIME_SYNC_STEP
+#define TIME_SYNC_STEP 500
+#endif
+
+#define CLOCK_HISTORY 8     // number of syncs kept for drift estimation
+#define CLOCK_MAD_LIMIT 3.0 // reject samples outside this many sigmas
+#define CLOCK_MAD_FLOOR 10  // [ms] never reject samples closer to median
+#define CLOCK_DRIFT_FLOOR 2 // [ppm] least residual drift after compensation
+
+int64_t clock_offset(uint32_t t_sec, int32_t t_msec);
+bool clock_discipline(const int64_t offsets[], uint8_t count,
+                      timesource_t source);
+bool clock_adjust(int64_t offset, timesource_t source);
+void clock_drift_apply(void);
+uint32_t clock_syncinterval(void);
+float clock_drift_ppm(void);
+float clock_drift_error(void);
+void clock_rtc_sync(void);
+
+#endif
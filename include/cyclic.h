@@ -14,8 +14,10 @@
 #include "led.h"
 #include "power.h"
 #include "button.h"
+#include "clockdisc.h"
+#include "telemetry.h"
 
-extern Ticker cyclicTimer;
+extern JobTimer cyclicTimer;
 
 void setCyclicIRQ(void);
 void doHousekeeping(void);
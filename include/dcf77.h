@@ -5,6 +5,7 @@
 
 #include "globals.h"
 #include "timekeeper.h"
+#include "hal/gpio_ll.h"
 
 #define set_dcfbit(b) (1ULL << (b))
 
@@ -14,7 +15,12 @@ enum dcf_pinstate { dcf_high, dcf_low };
 enum dcf_pinstate { dcf_low, dcf_high };
 #endif
 
-void DCF77_Pulse(uint8_t bit);
+#define DCF77_TICKS_0 10 // pulse length of logic 0 in clock ticks (100ms)
+#define DCF77_TICKS_1 20 // pulse length of logic 1 in clock ticks (200ms)
+
+void DCF77_Schedule(time_t t);
+void DCF77_Second(time_t t);
+void DCF77_Tick(uint8_t tick);
 uint64_t DCF77_Frame(const struct tm t);
 
 #endif
@@ -7,6 +7,7 @@
 #include "qrcode.h"
 #include "power.h"
 #include "timekeeper.h"
+#include "paxgraph.h"
 
 #define DISPLAY_PAGES (7) // number of paxcounter display pages
 #define PLOTBUFFERSIZE (MY_DISPLAY_WIDTH * MY_DISPLAY_HEIGHT / 8)
@@ -23,6 +24,7 @@ extern ONE_BIT_DISPLAY *dp;
 #define MY_FONT_LARGE FONT_16x32
 #define MY_FONT_STRETCHED FONT_12x16
 #define MY_DISPLAY_FIRSTLINE 30
+#define MY_GRAPH_TOP 9
 
 #ifndef MY_DISPLAY_RST
 #define MY_DISPLAY_RST NOT_A_PIN
@@ -70,6 +72,7 @@ extern BB_SPI_LCD *dp;
 #define MY_FONT_LARGE FONT_12x16
 #define MY_FONT_STRETCHED FONT_12x16
 #define MY_DISPLAY_FIRSTLINE 30
+#define MY_GRAPH_TOP 17
 #endif
 
 // Settings for small TFT display library
@@ -79,6 +82,7 @@ extern BB_SPI_LCD *dp;
 #define MY_FONT_LARGE FONT_16x16
 #define MY_FONT_STRETCHED FONT_12x16
 #define MY_DISPLAY_FIRSTLINE 30
+#define MY_GRAPH_TOP 9
 #endif
 
 // Default settings for all display types
@@ -94,10 +98,23 @@ extern BB_SPI_LCD *dp;
 #ifndef MY_DISPLAY_FIRSTLINE
 #define MY_DISPLAY_FIRSTLINE 0
 #endif
+#ifndef MY_GRAPH_TOP
+#define MY_GRAPH_TOP 0
+#endif
+
+// bytes transferred to display per frame
+#if (HAS_DISPLAY) == 1
+#define DP_FRAME_BYTES (MY_DISPLAY_WIDTH * MY_DISPLAY_HEIGHT / 8)
+#else
+#define DP_FRAME_BYTES (MY_DISPLAY_WIDTH * MY_DISPLAY_HEIGHT * 2)
+#endif
 
 const uint8_t QR_SCALEFACTOR = (MY_DISPLAY_HEIGHT - 4) / 29; // 4px borderlines
 extern uint8_t DisplayIsOn;
 extern hw_timer_t *displayIRQ;
+#if (HAS_DISPLAY) > 1
+extern TaskHandle_t dpFlushTask;
+#endif
 extern uint8_t volatile channel; // wifi channel rotation counter
 
 void dp_setup(int contrast = 0);
@@ -108,14 +125,9 @@ void dp_setFont(int font, int inv = 0);
 void dp_dump(uint8_t *pBuffer = NULL);
 void dp_contrast(uint8_t contrast);
 void dp_clear(void);
+void dp_logStats(void);
 void dp_power(uint8_t screenon);
 void dp_printqr(uint16_t offset_x, uint16_t offset_y, const char *Message);
-void dp_scrollHorizontal(uint8_t *buf, const uint16_t width,
-                         const uint16_t height, bool left = true);
-void dp_scrollVertical(uint8_t *buf, const uint16_t width,
-                       const uint16_t height, int offset = 0);
-int dp_drawPixel(uint8_t *buf, const uint16_t x, const uint16_t y,
-                 const uint8_t dot);
-void dp_plotCurve(uint16_t count, bool reset);
+void dp_plotCurve(uint8_t zoom);
 
 #endif
\ No newline at end of file
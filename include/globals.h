@@ -8,7 +8,8 @@
 #ifdef HAS_RTC
 #include <RtcDS3231.h>
 #endif
-#include <Ticker.h>
+#include "jobtimer.h"
+#include "staticalloc.h"
 
 // std::set for unified array functions
 #include <set>
@@ -50,6 +51,34 @@
 
 enum snifftype_t { MAC_SNIFF_WIFI, MAC_SNIFF_BLE, MAC_SNIFF_BLE_ENS };
 
+// transports for payload data, bits in port routing masks
+enum transport_t {
+  TRANSPORT_LORA,
+  TRANSPORT_SPI,
+  TRANSPORT_MQTT,
+  TRANSPORT_COUNT
+};
+
+#define ROUTE_LORA _bit(TRANSPORT_LORA)
+#define ROUTE_SPI _bit(TRANSPORT_SPI)
+#define ROUTE_MQTT _bit(TRANSPORT_MQTT)
+#define ROUTE_ALL (ROUTE_LORA | ROUTE_SPI | ROUTE_MQTT)
+
+// number of ports with individual routing rule, higher ports use ROUTE_ALL
+#ifndef ROUTE_PORTS
+#define ROUTE_PORTS 16
+#endif
+#ifndef PORTROUTE_DEFAULT
+#define PORTROUTE_DEFAULT ROUTE_ALL
+#endif
+
+// Struct holding the routing rule for payload on a port
+typedef struct __attribute__((packed)) {
+  uint8_t transports; // transports to send on, ROUTE_xxx bitmask
+  uint8_t fallback;   // transports used if all primary transports failed
+  uint8_t failover;   // [minutes] transport down time until it failed, 0=never
+} portRoute_t;
+
 // Struct holding devices's runtime configuration
 // using packed to avoid compiler padding, because struct will be memcpy'd to
 // byte array
@@ -73,6 +102,7 @@ typedef struct __attribute__((packed)) {
   uint8_t wifiant;       // 0=internal, 1=external (for LoPy/LoPy4)
   uint8_t rgblum;        // RGB Led luminosity (0..100%)
   uint8_t payloadmask;   // bitswitches for payload data
+  portRoute_t portroute[ROUTE_PORTS]; // transport routing rules per port
 
 #ifdef HAS_BME680
   uint8_t
@@ -82,6 +112,7 @@ typedef struct __attribute__((packed)) {
 
 // Struct holding payload for data send queue
 typedef struct {
+  uint32_t MessageTime; // millis() when message was enqueued
   uint8_t MessageSize;
   uint8_t MessagePort;
   uint8_t Message[PAYLOAD_BUFFER_SIZE];
@@ -111,6 +142,16 @@ typedef struct {
   float pm25;
 } sdsStatus_t;
 
+enum timesource_t { _gps, _rtc, _lora, _unsynced, _set };
+
+typedef struct {
+  int32_t ppm;       // learned error of sleep clock [ppm], positive = fast
+  uint16_t samples;  // number of synced wakeups learned from
+  uint32_t slept;    // duration of last deep sleep [sec]
+  int32_t residual;  // time error found at first sync after wakeup [ms]
+  uint32_t spread;   // error of the learned error [ppm]
+} sleepClock_t;
+
 extern char clientId[20]; // unique clientID
 
 #endif
@@ -3,23 +3,39 @@
 
 #if (HAS_GPS)
 
-#include <TinyGPS++.h> // library for parsing NMEA data
+#include "nmea.h"
 #include "timekeeper.h"
 
 #ifndef GPS_BAUDRATE
 #define GPS_BAUDRATE 115200UL
 #endif
 
-extern TinyGPSPlus gps; // Make TinyGPS++ instance globally availabe
-extern bool gps_location_isupdated; // Keep track of whether it was updated when showing on the display
+#ifndef GPS_MOVE_DISTANCE
+#define GPS_MOVE_DISTANCE 0
+#endif
+#ifndef GPS_MOVE_INTERVAL
+#define GPS_MOVE_INTERVAL 6
+#endif
+#ifndef GPS_BACKUP
+#define GPS_BACKUP 0
+#endif
+#ifndef GPS_BACKUP_LEAD
+#define GPS_BACKUP_LEAD 30
+#endif
+
 extern TaskHandle_t GpsTask;
 
 int gps_init(void);
 int gps_config();
 bool gps_hasfix();
+void gps_getfix(nmeaFix_t *fix);
+uint32_t gps_age(uint32_t stamp);
 bool gps_storelocation(gpsStatus_t *gps_store);
+bool gps_moved(const gpsStatus_t *gps_store);
+void gps_standby(uint32_t next_ms);
 void gps_loop(void *pvParameters);
 time_t get_gpstime(uint16_t *msec);
+uint32_t get_gpserror(void);
 
 #endif
 
@@ -6,10 +6,14 @@
 #include "globals.h"
 #include "timekeeper.h"
 #include "esp_sntp.h"
+#include "hal/uart_ll.h"
 
 #define IF482_FRAME_SIZE (17)
 #define IF482_SYNC_FIXUP (10) // calibration to fixup processing time [milliseconds]
 
+void IF482_Init(void);
+void IF482_Schedule(time_t t);
+void IF482_Tick(uint8_t tick, time_t t);
 String IF482_Frame(time_t t);
 
 #endif
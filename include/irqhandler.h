@@ -6,11 +6,11 @@
 #define SENDCYCLE_IRQ _bitl(2)
 #define CYCLIC_IRQ _bitl(3)
 #define TIMESYNC_IRQ _bitl(4)
-#define MASK_IRQ _bitl(5)
-#define UNMASK_IRQ _bitl(6)
+#define UNMASK_IRQ _bitl(6) // wakeup only, mask state is in irqhandler.cpp
 #define BME_IRQ _bitl(7)
 #define MATRIX_DISPLAY_IRQ _bitl(8)
 #define PMU_IRQ _bitl(9)
+#define LORA_SESSION_IRQ _bitl(10)
 
 #include "globals.h"
 #include "button.h"
@@ -21,7 +21,24 @@
 #include "power.h"
 #include "ledmatrixdisplay.h"
 
+#define IRQ_DEFER_MS 20 // retry period for irqs deferred by lmic [ms]
+
+typedef struct {
+  uint32_t irq;           // irq bit
+  void (*handler)(void);  // handler function
+  uint32_t deadline;      // max. dispatch latency [ms]
+  const char *name;
+} irqEvent_t;
+
+typedef struct {
+  uint32_t count;  // dispatched irqs
+  uint32_t misses; // dispatched later than deadline
+  uint32_t max_ms; // max. dispatch latency
+  uint32_t sum_ms; // sum of dispatch latencies
+} irqStats_t;
+
 void irqHandler(void *pvParameters);
+void irq_logStats(void);
 void mask_user_IRQ();
 void unmask_user_IRQ();
 void doIRQ(int irq);
@@ -32,8 +49,4 @@ extern TaskHandle_t irqHandlerTask;
 void IRAM_ATTR DisplayIRQ();
 #endif
 
-#ifdef HAS_MATRIX_DISPLAY
-void IRAM_ATTR MatrixDisplayIRQ();
-#endif
-
 #endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef _JOBTIMER_H
+#define _JOBTIMER_H
+
+#include <Arduino.h>
+
+#define JOBTIMER_SLACK_AUTO UINT32_MAX // slack = period / 8, max. SLACK_MAX
+#define JOBTIMER_SLACK_MAX 1000        // [ms]
+#define JOBTIMER_COARSE_MS 1000        // jobs >= 1 sec are due on full seconds
+#define JOBTIMER_FINE_MS 10            // shorter jobs on 10ms grid
+#define JOBTIMER_BATCH 16              // max. callbacks per wakeup
+
+// Periodic or one shot job, replaces Ticker. All jobs share one esp_timer,
+// jobs due within each others slack window are run on the same wakeup.
+class JobTimer {
+public:
+  typedef void (*callback_t)(void);
+
+  JobTimer();
+  ~JobTimer();
+
+  void attach(float seconds, callback_t callback,
+              uint32_t slack_ms = JOBTIMER_SLACK_AUTO);
+  void attach_ms(uint32_t milliseconds, callback_t callback,
+                 uint32_t slack_ms = JOBTIMER_SLACK_AUTO);
+  void once(float seconds, callback_t callback,
+            uint32_t slack_ms = JOBTIMER_SLACK_AUTO);
+  void once_ms(uint32_t milliseconds, callback_t callback,
+               uint32_t slack_ms = JOBTIMER_SLACK_AUTO);
+  void detach();
+  bool active();
+
+  JobTimer *next() { return _next; }
+  uint64_t deadline() { return _due + _slack; } // end of slack window [us]
+
+  static void service(void *arg);
+  static uint32_t wakeups(bool reset = false);
+
+private:
+  void start(uint64_t period_us, bool repeat, callback_t callback,
+             uint32_t slack_ms);
+  void unlink();
+
+  callback_t _callback;
+  uint64_t _due;    // esp_timer time when job is due [us]
+  uint64_t _period; // [us]
+  uint32_t _slack;  // job may be delayed up to .. [us]
+  bool _repeat;
+  JobTimer *_next;  // list of active jobs
+};
+
+#endif
@@ -9,6 +9,10 @@
 #include "lorawan.h"
 #endif
 
+#ifndef LED_IDLE_MS
+#define LED_IDLE_MS 1000 // recheck LoRaWAN state at least each second
+#endif
+
 #ifndef RGB_LED_COUNT
 #define RGB_LED_COUNT 1
 #endif
@@ -32,6 +36,7 @@ extern TaskHandle_t ledLoopTask;
 void rgb_led_init(void);
 void rgb_set_color(uint32_t color);
 void ledLoop(void *parameter);
+void led_wake(void);
 void switch_LED(led_states state);
 void switch_LED1(led_states state);
 
@@ -3,22 +3,35 @@
 
 #ifdef HAS_MATRIX_DISPLAY
 
+#include "jobtimer.h"
+#include <hal/gpio_ll.h>
 #include "LEDMatrix.h"
 #include "ledmatrixfonts.h"
 #include "ledmatrixdisplay.h"
 #include "configmanager.h"
+#include "paxgraph.h"
 #include <libpax_api.h>
 
+#define MATRIX_GLYPHS 16 // max. number of chars in a matrix font
+
+#ifndef MATRIX_DISPLAY_REFRESH_MS
+#define MATRIX_DISPLAY_REFRESH_MS 100 // content update cycle [ms]
+#endif
+
 extern uint8_t MatrixDisplayIsOn;
 extern LEDMatrix matrix;
 extern hw_timer_t *matrixDisplayIRQ;
+extern JobTimer matrixDisplayTimer;
 
 void init_matrix_display(bool reverse = false);
 void refreshTheMatrixDisplay(bool nextPage = false);
-void DrawNumber(String strNum, uint8_t iDotPos = 0);
+void setMatrixIRQ(void);
+void IRAM_ATTR MatrixScanIRQ(void);
+void DrawString(const char *str, uint8_t iDotPos = 0);
+void DrawNumber(uint32_t number, uint8_t iDotPos = 0);
 uint8_t GetCharFromFont(char cChar);
 uint8_t GetCharWidth(char cChar);
-void ScrollMatrixLeft(uint8_t *buf, const uint16_t cols, const uint16_t rows);
+void DrawGraph(uint8_t zoom);
 
 #endif
 
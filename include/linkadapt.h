@@ -0,0 +1,23 @@
+#ifndef _LINKADAPT_H
+#define _LINKADAPT_H
+
+#include <stdint.h>
+
+#ifndef LORA_LINKADAPT
+#define LORA_LINKADAPT 1
+#endif
+#ifndef LORA_LINKADAPT_MARGIN
+#define LORA_LINKADAPT_MARGIN 10
+#endif
+#ifndef LORA_LINKADAPT_CHECK
+#define LORA_LINKADAPT_CHECK 8
+#endif
+
+#define LINKADAPT_HISTORY 8 // number of SNR samples kept
+#define LINKADAPT_MINSAMPLES 3 // samples needed before going faster
+
+void linkadapt_reset(void);
+void linkadapt_txstart(void);
+void linkadapt_txcomplete(void);
+
+#endif
@@ -6,6 +6,10 @@
 #include "globals.h"
 #include "rcommand.h"
 #include "timekeeper.h"
+#include "sendstats.h"
+#include "linkadapt.h"
+#include "hash.h"
+#include <Preferences.h>
 #include <driver/rtc_io.h>
 
 // LMIC-Arduino LoRaWAN Stack
@@ -20,6 +24,36 @@
 #include <Wire.h>
 #endif
 
+#ifndef LORA_SESSION_PERSIST
+#define LORA_SESSION_PERSIST 1
+#endif
+#ifndef LORA_SESSION_FCNT_STEP
+#define LORA_SESSION_FCNT_STEP 32
+#endif
+#ifndef LORA_CONFIRM_EVERY
+#define LORA_CONFIRM_EVERY 1
+#endif
+#ifndef LORA_CONFIRM_SILENCE
+#define LORA_CONFIRM_SILENCE 0
+#endif
+#ifndef LORA_RETRY_BACKOFF
+#define LORA_RETRY_BACKOFF 30
+#endif
+#ifndef LORA_RETRY_BUDGET
+#define LORA_RETRY_BUDGET 20
+#endif
+#ifndef LORA_REJOIN_FAILS
+#define LORA_REJOIN_FAILS 0
+#endif
+// lmictask polls LMIC while the radio is active and this long after, else it
+// sleeps until the next scheduled LMIC job, but at most LMIC_IDLE_MS
+#ifndef LMIC_BUSY_MS
+#define LMIC_BUSY_MS 200
+#endif
+#ifndef LMIC_IDLE_MS
+#define LMIC_IDLE_MS 1000
+#endif
+
 extern TaskHandle_t lmicTask, lorasendTask;
 extern char lmic_event_msg[LMIC_EVENTMSG_LEN]; // display buffer
 
@@ -27,7 +61,14 @@ esp_err_t lmic_init(void);
 void lora_setupForNetwork(bool preJoin);
 void SaveLMICToRTC(uint32_t deepsleep_sec);
 void LoadLMICFromRTC();
+void lora_session_save(void);
+void lora_session_update(void);
+void lora_session_store(void);
+void lora_session_resume(void);
+bool lora_session_restore(void);
+void lora_session_erase(void);
 void lmictask(void *pvParameters);
+void lmic_wake(void);
 void gen_lora_deveui(uint8_t *pdeveui);
 void RevBytes(unsigned char *b, size_t c);
 void get_hard_deveui(uint8_t *pdeveui);
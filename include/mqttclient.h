@@ -6,6 +6,8 @@
 #include "globals.h"
 #include "rcommand.h"
 #include "hash.h"
+#include "sendstats.h"
+#include "payload.h"
 #include <MQTT.h>
 #include <ETH.h>
 #include <mbedtls/base64.h>
@@ -14,6 +16,16 @@
 #define MQTT_CLIENTNAME clientId
 #endif
 
+#ifndef MQTT_STATSTOPIC
+#define MQTT_STATSTOPIC "paxstats"
+#endif
+#ifndef MQTT_TELEMETRYTOPIC
+#define MQTT_TELEMETRYTOPIC "paxtelemetry"
+#endif
+#ifndef MQTT_STATSCYCLE
+#define MQTT_STATSCYCLE 300
+#endif
+
 extern TaskHandle_t mqttTask;
 
 void mqtt_enqueuedata(MessageBuffer_t *message);
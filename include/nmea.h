@@ -0,0 +1,36 @@
+#ifndef _NMEA_H
+#define _NMEA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define NMEA_MAXLEN 82 // max. length of a NMEA sentence, including $ and CRLF
+
+// GPS data decoded from NMEA RMC and GGA sentences. Each group of values has
+// a timestamp [millis] of its last update, 0 means never updated.
+typedef struct {
+  int32_t latitude;   // [1e-6 degrees], negative is south
+  int32_t longitude;  // [1e-6 degrees], negative is west
+  int32_t altitude;   // [cm] above mean sea level
+  uint16_t hdop;      // [1/100]
+  uint8_t satellites; // number of satellites in use
+  uint8_t hour, minute, second, centisecond; // UTC time
+  uint8_t day, month;                        // UTC date
+  uint16_t year;
+  uint32_t location_ms, altitude_ms, hdop_ms, satellites_ms, time_ms, date_ms;
+} nmeaFix_t;
+
+// streaming decoder, collects sentences and decodes RMC and GGA only
+typedef struct {
+  char line[NMEA_MAXLEN + 1];
+  uint8_t len;
+  bool skip;           // sentence is not of interest, wait for next '$'
+  uint32_t sentences;  // sentences decoded
+  uint32_t failed;     // sentences with bad checksum or format
+} nmeaDecoder_t;
+
+void nmea_feed(nmeaDecoder_t *dec, nmeaFix_t *fix, const char *data,
+               size_t len, uint32_t now_ms);
+bool nmea_parse(const char *s, size_t len, nmeaFix_t *fix, uint32_t now_ms);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef _PAXGRAPH_H
+#define _PAXGRAPH_H
+
+#include <stdint.h>
+
+#define PAXGRAPH_LEN 128 // values kept per zoom level
+
+// zoom levels of pax graph
+enum paxzoom_t { PAXGRAPH_CYCLE, PAXGRAPH_HOUR, PAXGRAPH_DAY, PAXGRAPH_ZOOMS };
+
+void paxgraph_add(uint16_t count);
+void paxgraph_live(uint16_t count);
+uint16_t paxgraph_get(uint8_t zoom, uint16_t *values, uint16_t n);
+uint16_t paxgraph_max(const uint16_t *values, uint16_t n);
+uint32_t paxgraph_revision(void);
+
+#endif
@@ -4,6 +4,8 @@
 #include "sensor.h"
 #include "sds011read.h"
 #include "gpsread.h"
+#include "sendstats.h"
+#include "telemetry.h"
 
 // MyDevices CayenneLPP 1.0 channels for Synamic sensor payload format
 // all payload goes out on LoRa FPort 1
@@ -58,6 +60,9 @@ public:
   void addSensor(uint8_t[]);
   void addTime(time_t value);
   void addSDS(sdsStatus_t value);
+  void addSendStats(uint8_t page, sendStats_t value);
+  void addSleepClock(uint8_t page, sleepClock_t value);
+  void addTelemetry(telemetry_t value);
 
 private:
   void addChars( char* string, int len);
@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <esp_adc_cal.h>
 #include <soc/adc_channel.h>
+#include <esp_pm.h>
 
 #include "i2c.h"
 #include "reset.h"
@@ -57,6 +58,27 @@ extern RTC_NOINIT_ATTR uint64_t RTC_reg_b;
 #include "soc/sens_reg.h" // needed for adc pin reset
 #endif
 
+// power management: with POWER_MANAGEMENT set, cpu clock is scaled down to
+// PM_MIN_FREQ and, if tickless idle is enabled in sdkconfig, the chip light
+// sleeps while all tasks wait and no lock below is held
+#ifndef POWER_MANAGEMENT
+#define POWER_MANAGEMENT 0
+#endif
+#ifndef PM_MIN_FREQ
+#define PM_MIN_FREQ 80 // MHz, 80 keeps APB clock of UART, SPI and I2C constant
+#endif
+
+// peripherals which need the chip awake
+enum pmLock_t {
+  PM_RADIO,   // LoRa radio and LMIC timing
+  PM_DISPLAY, // display refresh timer
+  PM_PERIPH,  // UART, hardware timers or interrupt lines of other devices
+  PM_LOCKS
+};
+
+void pm_init(void);
+void pm_hold(pmLock_t lock, bool hold);
+
 typedef uint8_t (*mapFn_t)(uint16_t, uint16_t, uint16_t);
 
 uint16_t read_voltage(void);
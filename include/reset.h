@@ -10,12 +10,20 @@
 #include "power.h"
 #include "sdcard.h"
 #include "sds011read.h"
+#include "timekeeper.h"
+
+#define SLEEP_LEARN_MIN 300    // learn from sleeps of at least .. seconds
+#define SLEEP_PPM_LIMIT 100000 // plausible sleep clock error [ppm]
+#define SLEEP_DRIFT_UNLEARNED 2000 // assumed sleep clock error, unlearned [ppm]
+#define SLEEP_DRIFT_FLOOR 50 // least sleep clock error after learning [ppm]
 
 void reset_rtc_vars(void);
 void do_reset(bool warmstart);
 void do_after_reset(void);
 void enter_deepsleep(uint32_t wakeup_sec, const gpio_num_t wakeup_gpio);
 uint64_t uptime(void);
+void sleep_learn(int64_t offset_ms, timesource_t source);
+void sleep_clock(sleepClock_t *value);
 
 enum runmode_t {
   RUNMODE_POWERCYCLE,
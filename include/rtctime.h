@@ -14,6 +14,7 @@ uint8_t rtc_init(void);
 uint8_t set_rtctime(time_t t);
 void sync_rtctime(void);
 time_t get_rtctime(uint16_t *msec);
+uint32_t get_rtcerror(void);
 float get_rtctemp(void);
 
 #endif
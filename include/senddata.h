@@ -7,10 +7,14 @@
 #include "sensor.h"
 #include "lorawan.h"
 #include "display.h"
+#include "paxgraph.h"
 #include "sdcard.h"
 #include "payload.h"
+#include "sendstats.h"
 
 void SendPayload(uint8_t port);
+void route_setlink(transport_t transport, bool up);
+bool sendcycle_due(transport_t transport, uint32_t within_ms);
 void sendData(void);
 void checkSendQueues(void);
 void flushQueues(void);
@@ -0,0 +1,30 @@
+#ifndef _SENDSTATS_H
+#define _SENDSTATS_H
+
+#include "globals.h"
+
+// log-scale histogram: bucket 0 counts times below STATS_BUCKET_MS, each
+// following bucket covers a 4 times wider range, last bucket is open ended
+// -> 64ms, 256ms, 1s, 4s, 16s, 65s, 262s, above
+#define STATS_BUCKETS 8
+#define STATS_BUCKET_MS 64
+
+// send path statistics of a transport, counters saturate
+typedef struct {
+  uint32_t sent;                   // messages transmitted
+  uint16_t drops;                  // messages dropped, queue full or error
+  uint16_t retries;                // transmit attempts which had to be repeated
+  uint16_t toolarge;               // messages discarded by transport for size
+  uint8_t queue_hwm;               // send queue depth high-water mark
+  uint16_t wait[STATS_BUCKETS];    // time from enqueue until transmit start
+  uint16_t latency[STATS_BUCKETS]; // time from transmit start until done
+} sendStats_t;
+
+void stats_enqueued(transport_t transport, uint32_t depth);
+void stats_dropped(transport_t transport);
+void stats_retried(transport_t transport, uint16_t count);
+void stats_toolarge(transport_t transport);
+void stats_sent(transport_t transport, uint32_t enqueued, uint32_t started);
+void stats_get(transport_t transport, sendStats_t *stats);
+
+#endif
@@ -28,6 +28,23 @@ licenses. Refer to LICENSE.txt file in repository for more details.
 
 #include "globals.h"
 #include "rcommand.h"
+#include "sendstats.h"
+
+#ifndef SPI_PROTOCOL
+#define SPI_PROTOCOL 1
+#endif
+
+// SPI transaction size needs to be dividable by 4
+#ifndef SPI_V2_BUFFER_SIZE
+#define SPI_V2_BUFFER_SIZE 512
+#endif
+#ifndef SPI_V2_POLL_MS
+#define SPI_V2_POLL_MS 100
+#endif
+
+#if (SPI_PROTOCOL == 2) && (SPI_V2_BUFFER_SIZE % 4)
+#error SPI_V2_BUFFER_SIZE must be a multiple of 4
+#endif
 
 extern TaskHandle_t spiTask;
 
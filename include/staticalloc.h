@@ -0,0 +1,47 @@
+#ifndef _STATICALLOC_H
+#define _STATICALLOC_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+// With STATIC_ALLOC set, queues and tasks are created in storage reserved at
+// compile time instead of on the heap, so they can't fragment it and a build
+// which does not fit in RAM fails at link time. Storage belongs to the call
+// site, which thus must not create a second object while the first exists.
+#ifndef STATIC_ALLOC
+#define STATIC_ALLOC 0
+#endif
+
+#if (STATIC_ALLOC)
+
+// length and size must be compile time constants
+#define QUEUE_CREATE(length, size)                                             \
+  ({                                                                           \
+    static uint8_t _storage[(length) * (size)];                                \
+    static StaticQueue_t _queue;                                               \
+    xQueueCreateStatic((length), (size), _storage, &_queue);                   \
+  })
+
+// stack size must be a compile time constant, returns pdPASS if created
+#define TASK_CREATE(function, name, stack, param, prio, handle, core)          \
+  ({                                                                           \
+    static StackType_t _stack[(stack)];                                        \
+    static StaticTask_t _tcb;                                                  \
+    TaskHandle_t _task = xTaskCreateStaticPinnedToCore(                        \
+        (function), (name), (stack), (param), (prio), _stack, &_tcb, (core));  \
+    if ((handle) != NULL)                                                      \
+      *(TaskHandle_t *)(handle) = _task;                                       \
+    _task ? pdPASS : errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;                    \
+  })
+
+#else
+
+#define QUEUE_CREATE(length, size) xQueueCreate((length), (size))
+#define TASK_CREATE(function, name, stack, param, prio, handle, core)          \
+  xTaskCreatePinnedToCore((function), (name), (stack), (param), (prio),        \
+                          (handle), (core))
+
+#endif
+
+#endif
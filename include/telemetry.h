@@ -0,0 +1,82 @@
+#ifndef _TELEMETRY_H
+#define _TELEMETRY_H
+
+#include "globals.h"
+
+#ifndef TELEMETRYPORT
+#define TELEMETRYPORT 13
+#endif
+
+// tasks with a stack high-water mark below this are logged as warning
+#ifndef TELEMETRY_STACK_LOW
+#define TELEMETRY_STACK_LOW 512
+#endif
+
+// heap trends are computed over this many housekeeping cycles
+#ifndef HEAP_TREND_CYCLES
+#define HEAP_TREND_CYCLES 10
+#endif
+
+// free heap must fall at least this fast to be taken as leak [bytes/hour];
+// heap exhausted for HEAP_TREND_CYCLES in a row resets the device as well
+#ifndef HEAP_LEAK_TREND
+#define HEAP_LEAK_TREND 8192
+#endif
+
+// CPU load of a task is only available if FreeRTOS run time statistics are
+// enabled (CONFIG_FREERTOS_USE_TRACE_FACILITY and
+// CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS in sdkconfig)
+#if (configUSE_TRACE_FACILITY == 1) && (configGENERATE_RUN_TIME_STATS == 1)
+#define TELEMETRY_RUNTIME 1
+#else
+#define TELEMETRY_RUNTIME 0
+#endif
+
+#define TELEMETRY_CPU_NA 255 // CPU load not available
+#define TELEMETRY_TASKS 14   // maximum number of tasks in a record
+
+// ids of tasks in a telemetry record, do not renumber
+enum telemetryTask_t {
+  TM_IDLE0 = 0,
+  TM_IDLE1 = 1,
+  TM_IRQHANDLER = 2,
+  TM_RCOMMAND = 3,
+  TM_LMIC = 4,
+  TM_LORASEND = 5,
+  TM_GPS = 6,
+  TM_SPI = 7,
+  TM_MQTT = 8,
+  TM_CLOCK = 9,
+  TM_LED = 10,
+  TM_BUTTON = 11,
+  TM_DPFLUSH = 12
+};
+
+typedef struct {
+  uint8_t id;     // telemetryTask_t
+  uint8_t cpu;    // CPU load on its core in last cycle [0.5%], 255 = n/a
+  uint16_t stack; // stack high-water mark [bytes]
+} taskStats_t;
+
+// state of internal heap, as seen by the memory watchdog
+enum heapState_t {
+  HEAP_OK,
+  HEAP_LOW,       // free heap exhausted, but not falling steadily
+  HEAP_LEAK,      // free heap exhausted and falling by HEAP_LEAK_TREND
+  HEAP_FRAGMENTED // enough free heap, but largest free block too small
+};
+
+typedef struct {
+  uint32_t heap_min;   // lowest free internal heap since boot [bytes]
+  uint32_t heap_block; // largest free internal heap block [bytes]
+  int32_t heap_trend;  // change of free heap [bytes/hour]
+  int32_t block_trend; // change of largest free block [bytes/hour]
+  uint8_t tasks;       // number of valid entries in task[]
+  taskStats_t task[TELEMETRY_TASKS];
+} telemetry_t;
+
+void telemetry_sample(void);
+void telemetry_get(telemetry_t *value);
+heapState_t telemetry_heapstate(void);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef _TIMEFUSION_H
+#define _TIMEFUSION_H
+
+#include "globals.h"
+#include "timekeeper.h"
+
+// assumed error of time sources [milliseconds]
+#define TIME_ERROR_GPS_PPS 2   // GPS with PPS pulse
+#define TIME_ERROR_GPS 100     // GPS without PPS, NMEA sentence timing
+#define TIME_ERROR_RTC_PULSE 5 // RTC with 1Hz pulse
+#define TIME_ERROR_RTC 1000    // RTC without pulse, one second resolution
+#define TIME_ERROR_LORA 20     // LORA, least error of a timeserver answer
+
+// assumed drift of clocks while running free [ppm]
+#define TIME_DRIFT_RTC 2  // DS3231 temperature compensated
+#define TIME_DRIFT_SYS 20 // ESP32 crystal
+
+#define TIME_ERROR_UNKNOWN UINT32_MAX
+
+// required accuracy [milliseconds], 0 means no requirement
+#ifndef TIME_SYNC_ACCURACY
+#define TIME_SYNC_ACCURACY 0 // don't poll time sources while within
+#endif
+#ifndef TIME_CLOCK_ACCURACY
+#define TIME_CLOCK_ACCURACY 0 // suspend DCF77/IF482 output while exceeded
+#endif
+#ifndef TIME_WAKEUP_ACCURACY
+#define TIME_WAKEUP_ACCURACY 0 // don't sync wakeup while exceeded
+#endif
+
+typedef struct {
+  int64_t offset;       // reference time - system time [ms]
+  uint32_t error;       // error bound of reference time [ms]
+  timesource_t source;
+} timeSample_t;
+
+bool time_fuse(const timeSample_t samples[], uint8_t count);
+uint32_t time_errorbound(void);
+bool time_accurate(uint32_t required);
+void time_forget(void);
+void time_sleep(void);
+void time_wakeup(int64_t slept_ms, uint32_t drift_ppm);
+
+#endif
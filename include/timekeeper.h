@@ -9,6 +9,7 @@
 #include "if482.h"
 #include "dcf77.h"
 #include "esp_sntp.h"
+#include "calendar.h"
 
 #define HAS_LORA_TIME                                                          \
   ((HAS_LORA) && ((TIME_SYNC_LORASERVER) || (TIME_SYNC_LORAWAN)))
@@ -18,10 +19,8 @@
 #define GPS_UTC_DIFF 315964800UL      // seconds diff between gps and utc epoch
 #define LEAP_SECS_SINCE_GPSEPOCH 18UL // state of 2021
 
-enum timesource_t { _gps, _rtc, _lora, _unsynced, _set };
-
 extern const char timeSetSymbols[];
-extern Ticker timesyncer;
+extern JobTimer timesyncer;
 extern timesource_t timeSource;
 extern TaskHandle_t ClockTask;
 extern DRAM_ATTR bool TimePulseTick; // 1sec pps flag set by GPS or RTC
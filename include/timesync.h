@@ -9,6 +9,11 @@
 #define TIME_SYNC_FIXUP 25 // compensation for processing time [milliseconds]
 #define TIME_SYNC_MAX_SEQNO 0xfe // threshold for wrap around time_sync_seqNo
 #define TIME_SYNC_END_FLAG (TIME_SYNC_MAX_SEQNO + 1) // end of handshake marker
+#define TIME_SYNC_AIRTIME 3 // max. time on air of an uplink [seconds]
+
+#ifndef TIME_SYNC_PIGGYBACK
+#define TIME_SYNC_PIGGYBACK 0
+#endif
 
 enum timesync_t {
   timesync_tx,
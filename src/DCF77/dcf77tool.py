@@ -0,0 +1,256 @@
+#!/usr/bin/env python3
+# Generator and verifier for the DCF77 signal of the paxcounter clock output
+# (#define HAS_DCF77), to check a clock controller with a logic analyzer.
+#
+# usage: dcf77tool.py frame "2026-03-29 01:59" [--tz Europe/Berlin]
+#        dcf77tool.py decode 0x...
+#        dcf77tool.py generate "2026-03-29 01:55" 10 [--tz ...] > pulses.csv
+#        dcf77tool.py verify pulses.csv [--tolerance 30]
+#
+# frame     prints the frame sent in the minute before the given local time
+# decode    decodes a frame, e.g. as logged by the device with debug level
+# generate  writes the pulses of some minutes, sent from the given local time
+# verify    checks recorded pulses against DCF77 timing and frame rules
+#
+# pulses.csv, one pulse per line, lines starting with # are ignored:
+#   start,width
+#   start = time of falling edge (start of pulse) [ms]
+#   width = pulse length [ms]
+# Logic analyzers can export this with a pulse width measurement.
+#
+# Frame layout mirrors src/dcf77.cpp: bit n is sent in second n, second 59
+# has no pulse. A pulse of 100ms is logic 0, 200ms is logic 1.
+
+import argparse
+import csv
+import datetime
+import sys
+
+try:
+    from zoneinfo import ZoneInfo
+except ImportError:  # python < 3.9
+    ZoneInfo = None
+
+BCD_FIELDS = [  # name, first bit, last bit, parity bit group
+    ("minute", 21, 27, 28),
+    ("hour", 29, 34, 35),
+    ("day", 36, 41, 58),
+    ("weekday", 42, 44, 58),
+    ("month", 45, 49, 58),
+    ("year", 50, 57, 58),
+]
+RANGES = {"minute": (0, 59), "hour": (0, 23), "day": (1, 31),
+          "weekday": (1, 7), "month": (1, 12), "year": (0, 99)}
+
+
+def bcd(value, first, last):
+    data = (value // 10) << 4 | value % 10
+    frame = 0
+    for i in range(first, last + 1):
+        frame |= (data & 1) << i
+        data >>= 1
+    return frame
+
+
+def parity(frame, first, last):
+    return bin((frame >> first) & ((1 << (last - first + 1)) - 1)).count("1") & 1
+
+
+def make_frame(local, dst, announce=False):
+    # frame carrying local time `local`
+    frame = (1 << 17) if dst else (1 << 18)
+    frame |= 1 << 20
+    if announce:
+        frame |= 1 << 16
+    frame |= bcd(local.minute, 21, 27)
+    frame |= parity(frame, 21, 27) << 28
+    frame |= bcd(local.hour, 29, 34)
+    frame |= parity(frame, 29, 34) << 35
+    frame |= bcd(local.day, 36, 41)
+    frame |= bcd(local.isoweekday(), 42, 44)
+    frame |= bcd(local.month, 45, 49)
+    frame |= bcd(local.year % 100, 50, 57)
+    frame |= parity(frame, 36, 57) << 58
+    return frame
+
+
+def decode(frame):
+    # returns dict of fields and list of rule violations
+    errors = []
+    fields = {}
+    if frame & 1:
+        errors.append("bit 0 (start of minute) must be 0")
+    if not frame >> 20 & 1:
+        errors.append("bit 20 (start of time) must be 1")
+    if (frame >> 17 & 1) == (frame >> 18 & 1):
+        errors.append("bits 17/18 (CEST/CET) must differ")
+    for name, first, last, _ in BCD_FIELDS:
+        data = (frame >> first) & ((1 << (last - first + 1)) - 1)
+        units, tens = data & 0xF, data >> 4
+        if units > 9:
+            errors.append("%s: invalid BCD digit" % name)
+        fields[name] = tens * 10 + units
+        lo, hi = RANGES[name]
+        if not lo <= fields[name] <= hi:
+            errors.append("%s: %d out of range" % (name, fields[name]))
+    if parity(frame, 21, 28):
+        errors.append("minute parity (bit 28) wrong")
+    if parity(frame, 29, 35):
+        errors.append("hour parity (bit 35) wrong")
+    if parity(frame, 36, 58):
+        errors.append("date parity (bit 58) wrong")
+    fields["dst"] = bool(frame >> 17 & 1)
+    fields["announce"] = bool(frame >> 16 & 1)
+    return fields, errors
+
+
+def fmt(fields):
+    return "20%02d-%02d-%02d %02d:%02d (weekday %d%s%s)" % (
+        fields["year"], fields["month"], fields["day"], fields["hour"],
+        fields["minute"], fields["weekday"],
+        ", CEST" if fields["dst"] else ", CET",
+        ", change announced" if fields["announce"] else "")
+
+
+def local_minutes(start, count, tz):
+    # (local time, dst, announce) of `count` minutes from local `start`
+    utc = datetime.timezone.utc
+    t = start.replace(tzinfo=tz).astimezone(utc)
+    for _ in range(count):
+        local = t.astimezone(tz)
+        later = (t + datetime.timedelta(hours=1)).astimezone(tz)
+        yield (local, bool(local.dst()),
+               local.utcoffset() != later.utcoffset())
+        t += datetime.timedelta(minutes=1)
+
+
+def get_tz(name):
+    if ZoneInfo is None:
+        sys.exit("python >= 3.9 needed for time zones")
+    return ZoneInfo(name)
+
+
+def cmd_frame(args):
+    tz = get_tz(args.tz)
+    local = datetime.datetime.strptime(args.time, "%Y-%m-%d %H:%M")
+    local, dst, announce = next(local_minutes(local, 1, tz))
+    frame = make_frame(local, dst, announce)
+    print("0x%016x" % frame)
+    print("".join(str(frame >> i & 1) for i in range(59)))
+
+
+def cmd_decode(args):
+    fields, errors = decode(int(args.frame, 0))
+    print(fmt(fields))
+    for e in errors:
+        print("error:", e)
+    return 1 if errors else 0
+
+
+def cmd_generate(args):
+    tz = get_tz(args.tz)
+    start = datetime.datetime.strptime(args.time, "%Y-%m-%d %H:%M")
+    out = csv.writer(sys.stdout)
+    out.writerow(["# start", "width"])
+    # frame sent in a minute carries the time of the following minute
+    minutes = list(local_minutes(start, args.minutes + 1, tz))
+    for n, (local, dst, announce) in enumerate(minutes[1:]):
+        frame = make_frame(local, dst, announce)
+        for s in range(59):
+            width = 200 if frame >> s & 1 else 100
+            out.writerow([(n * 60 + s) * 1000, width])
+
+
+def check_minute(frame, last):
+    # decode frame of a complete minute, check it follows the last one
+    fields, errs = decode(frame)
+    print(fmt(fields))
+    for e in errs:
+        print("  error:", e)
+    if errs:
+        last["time"] = None
+        return len(errs)
+    got = datetime.datetime(2000 + fields["year"], fields["month"],
+                            fields["day"], fields["hour"], fields["minute"])
+    expect = last["time"] and last["time"] + datetime.timedelta(minutes=1)
+    # local time may jump after an announced DST change
+    bad = expect and got != expect and not last["announce"]
+    if bad:
+        print("  error: expected %s" % expect)
+    last["time"], last["announce"] = got, fields["announce"]
+    return 1 if bad else 0
+
+
+def cmd_verify(args):
+    tol = args.tolerance
+    pulses = []
+    with open(args.file) as f:
+        for row in csv.reader(f):
+            if not row or row[0].lstrip().startswith("#"):
+                continue
+            pulses.append((float(row[0]), float(row[1])))
+
+    errors = 0
+    frame, bit, prev = 0, None, None
+    last = {"time": None, "announce": False}
+    for start, width in pulses:
+        if prev is not None:
+            gap = start - prev
+            if abs(gap - 2000) <= tol:  # missing pulse in second 59
+                if bit == 59:
+                    errors += check_minute(frame, last)
+                elif bit is not None:
+                    print("error: minute mark after %d pulses at %.0f ms"
+                          % (bit, start))
+                    errors += 1
+                frame, bit = 0, 0
+            elif abs(gap - 1000) > tol:
+                print("error: pulse period %.0f ms at %.0f ms" % (gap, start))
+                errors += 1
+                bit = None  # resynchronize at next minute mark
+        prev = start
+
+        if abs(width - 100) <= tol:
+            value = 0
+        elif abs(width - 200) <= tol:
+            value = 1
+        else:
+            print("error: pulse width %.0f ms at %.0f ms" % (width, start))
+            errors += 1
+            bit = None
+            continue
+        if bit is not None:
+            frame |= value << bit
+            bit += 1
+
+    print("%d pulses, %d errors" % (len(pulses), errors))
+    return 1 if errors else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+    p = sub.add_parser("frame")
+    p.add_argument("time")
+    p.add_argument("--tz", default="Europe/Berlin")
+    p = sub.add_parser("decode")
+    p.add_argument("frame")
+    p = sub.add_parser("generate")
+    p.add_argument("time")
+    p.add_argument("minutes", type=int)
+    p.add_argument("--tz", default="Europe/Berlin")
+    p = sub.add_parser("verify")
+    p.add_argument("file")
+    p.add_argument("--tolerance", type=float, default=30,
+                   help="allowed timing error [ms]")
+    args = parser.parse_args()
+    commands = {"frame": cmd_frame, "decode": cmd_decode,
+                "generate": cmd_generate, "verify": cmd_verify}
+    if args.cmd not in commands:
+        parser.print_help()
+        return 2
+    return commands[args.cmd](args) or 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+# Offline simulator for the LoRa link adaptation of the paxcounter
+# (#define LORA_LINKADAPT 1, used if ADR is off), replays a recorded link
+# trace and compares it with fixed datarates.
+#
+# usage: linksim.py trace.csv [--margin 10] [--check 8] [--start 5]
+#                   [--payload 4] [--verbose]
+#
+# trace.csv, one line per uplink, lines starting with # are ignored:
+#   snr[,confirmed]
+#   snr       = SNR of the link at this uplink [dB], e.g. as recorded by
+#               the gateway (TTN console metadata) or from downlinks
+#   confirmed = 1 if uplink was confirmed (network answers with ack),
+#               0 or missing if unconfirmed (no downlink)
+#
+# An uplink is received if the link SNR is at least the demodulation floor of
+# the datarate's spreading factor. A downlink is received for a received
+# confirmed uplink; its SNR is the link SNR. Unconfirmed uplinks carry a link
+# check request after --check uplinks without a sample, a received one is
+# answered with the gateway margin in whole dB. Datarates are EU868 DR0..DR5.
+#
+# Algorithm mirrors src/linkadapt.cpp, keep both in sync.
+
+import argparse
+import csv
+import math
+
+HISTORY = 8  # LINKADAPT_HISTORY
+MINSAMPLES = 3  # LINKADAPT_MINSAMPLES
+
+# EU868 DR -> spreading factor, all 125kHz
+SF = {0: 12, 1: 11, 2: 10, 3: 9, 4: 8, 5: 7}
+
+
+def sf_floor(sf):
+    # demodulation floor [dB/4], SF7 = -7.5dB ... SF12 = -20dB
+    return -(30 + 10 * (sf - 7))
+
+
+def airtime(sf, payload, bw=125000, cr=1, preamble=8):
+    # LoRa time on air [ms], LoRaWAN adds 13 bytes of header and MIC
+    pl = payload + 13
+    tsym = (2 ** sf) / bw * 1000
+    de = 1 if sf >= 11 else 0
+    n = 8 + max(math.ceil((8 * pl - 4 * sf + 28 + 16) / (4 * (sf - 2 * de)))
+                * (cr + 4), 0)
+    return (preamble + 4.25 + n) * tsym
+
+
+class LinkAdapt:
+    def __init__(self, dr, margin, check=8):
+        self.dr = dr
+        self.margin = margin * 4
+        self.check = check
+        self.hist = []
+        self.unsampled = 0
+
+    def txstart(self):
+        # True if the uplink carries a link check request
+        self.unsampled += 1
+        if self.check and self.unsampled >= self.check:
+            self.unsampled = 0
+            return True
+        return False
+
+    def neighbour(self, step):
+        # next datarate faster (+1) or slower (-1), or None
+        dr = self.dr + step
+        return dr if dr in SF else None
+
+    def sample(self, snr):
+        self.unsampled = 0
+        snr = int(snr * 4)  # LMIC.snr is in dB/4
+        self.hist = (self.hist + [snr])[-HISTORY:]
+        worst = min(self.hist)
+        if worst - sf_floor(SF[self.dr]) < self.margin:
+            # margin lost, go down until we have it again or reach slowest
+            while self.neighbour(-1) is not None:
+                self.dr -= 1
+                if worst - sf_floor(SF[self.dr]) >= self.margin:
+                    break
+        elif len(self.hist) >= MINSAMPLES and self.neighbour(+1) is not None:
+            nxt = self.neighbour(+1)
+            if worst - sf_floor(SF[nxt]) >= self.margin:
+                self.dr = nxt
+
+    def missed(self):
+        self.hist = []
+        if self.neighbour(-1) is not None:
+            self.dr -= 1
+
+
+def replay(trace, dr, payload, adapt=None, verbose=False):
+    sent = received = 0
+    air = 0.0
+    for i, (snr, confirmed) in enumerate(trace):
+        linkcheck = False
+        if adapt:
+            dr = adapt.dr
+            linkcheck = adapt.txstart()
+        sf = SF[dr]
+        ok = snr * 4 >= sf_floor(sf)
+        sent += 1
+        received += ok
+        air += airtime(sf, payload)
+        if verbose:
+            print("%5d snr %6.1f DR%d SF%-2d %s" %
+                  (i, snr, dr, sf, "ok" if ok else "lost"))
+        if adapt and confirmed:
+            if ok:
+                adapt.sample(snr)
+            else:
+                adapt.missed()
+        elif adapt and linkcheck and ok:
+            margin = int(snr - sf_floor(sf) / 4)
+            adapt.sample(sf_floor(sf) / 4 + margin)
+    return sent, received, air
+
+
+def main():
+    parser = argparse.ArgumentParser(description="LoRa link adaptation "
+                                     "simulator")
+    parser.add_argument("trace")
+    parser.add_argument("--margin", type=int, default=10,
+                        help="LORA_LINKADAPT_MARGIN [dB]")
+    parser.add_argument("--check", type=int, default=8,
+                        help="LORA_LINKADAPT_CHECK [uplinks], 0 = off")
+    parser.add_argument("--start", type=int, default=5,
+                        help="start datarate (cfg.loradr)")
+    parser.add_argument("--payload", type=int, default=4,
+                        help="payload size [bytes]")
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+
+    trace = []
+    with open(args.trace) as f:
+        for row in csv.reader(f):
+            if not row or row[0].lstrip().startswith("#"):
+                continue
+            confirmed = len(row) > 1 and row[1].strip() == "1"
+            trace.append((float(row[0]), confirmed))
+
+    print("%-10s %8s %8s %12s" % ("mode", "sent", "lost", "airtime[s]"))
+    for dr in sorted(SF):
+        sent, received, air = replay(trace, dr, args.payload)
+        print("%-10s %8d %8d %12.1f" % ("DR%d" % dr, sent, sent - received,
+                                         air / 1000))
+    adapt = LinkAdapt(args.start, args.margin, args.check)
+    sent, received, air = replay(trace, args.start, args.payload, adapt,
+                                 args.verbose)
+    print("%-10s %8d %8d %12.1f" % ("adaptive", sent, sent - received,
+                                     air / 1000))
+
+
+if __name__ == "__main__":
+    main()
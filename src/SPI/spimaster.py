@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+# Reference SPI master for Paxcounter SPI protocol 2 (#define SPI_PROTOCOL 2)
+# runs on a linux host with spidev, e.g. a Raspberry Pi wired to the
+# paxcounter's SPI slave pins (SPI_MOSI, SPI_MISO, SPI_SCLK, SPI_CS)
+#
+# usage: spimaster.py [--bus 0] [--device 0] [--speed 1000000]
+#                     [--interval 1.0] [--command 81]
+#
+# prints each received message as: <sequence> <port> <payload hex>
+# protocol description see src/spislave.cpp
+
+import argparse
+import sys
+import time
+
+BUFFER_SIZE = 512  # must match SPI_V2_BUFFER_SIZE of the device
+PROTOCOL = 2
+FLAG_SYNC = 0x01
+RCMDPORT = 2
+HEADER_SIZE = 6
+
+
+def crc16(data):
+    # CRC-16/GENIBUS, same as crc16_be(0, ...) of ESP32 ROM
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc ^ 0xFFFF
+
+
+def message(seq, port, payload):
+    body = bytes([seq & 0xFF, seq >> 8, port, len(payload)]) + bytes(payload)
+    crc = crc16(body)
+    return bytes([crc & 0xFF, crc >> 8]) + body
+
+
+class SpiMaster:
+    def __init__(self, xfer, size=BUFFER_SIZE):
+        self.xfer = xfer  # function clocking out and in one transaction
+        self.size = size
+        self.expected = None  # next sequence number we accept
+        self.sync_run = False
+        self.commands = []
+
+    def send_command(self, cmd):
+        self.commands.append(bytes(cmd))
+
+    def _tx(self):
+        tx = bytearray(self.size)
+        count = 0
+        if self.commands:
+            # kept until a slave transaction took it, see poll()
+            msg = message(0, RCMDPORT, self.commands[0])
+            tx[HEADER_SIZE:HEADER_SIZE + len(msg)] = msg
+            count = 1
+        if self.expected is None and not count:
+            return tx  # nothing to acknowledge, send zeros
+        ack = ((self.expected or 0) - 1) & 0xFFFF
+        tx[2:6] = bytes([PROTOCOL, count, ack & 0xFF, ack >> 8])
+        crc = crc16(tx[2:6])
+        tx[0:2] = bytes([crc & 0xFF, crc >> 8])
+        return tx
+
+    def poll(self):
+        # clock one transaction, return list of (seq, port, payload)
+        # received in order
+        tx = self._tx()
+        rx = bytes(self.xfer(tx))
+        received = []
+        if len(rx) < HEADER_SIZE:
+            return received
+        if len(set(rx[:HEADER_SIZE])) == 1:
+            # slave has no transaction armed, so it has no unacknowledged
+            # messages and a following sync flag means it restarted
+            self.sync_run = False
+            return received
+        if rx[2] != PROTOCOL or (rx[0] | rx[1] << 8) != crc16(rx[2:6]):
+            return received  # broken
+        if tx[3]:
+            self.commands.pop(0)
+        count, flags = rx[3], rx[4]
+
+        # slave restarted its sequence numbers
+        if flags & FLAG_SYNC:
+            if not self.sync_run:
+                self.expected = 0
+                self.sync_run = True
+        else:
+            self.sync_run = False
+
+        cursor = HEADER_SIZE
+        for _ in range(count):
+            if cursor + HEADER_SIZE > len(rx):
+                break
+            size = rx[cursor + 5]
+            end = cursor + HEADER_SIZE + size
+            if end > len(rx) or (rx[cursor] | rx[cursor + 1] << 8) != crc16(
+                    rx[cursor + 2:end]):
+                break  # corrupted, slave will send again from here
+            seq = rx[cursor + 2] | rx[cursor + 3] << 8
+            if self.expected is None:
+                self.expected = seq
+            if seq == self.expected:
+                received.append((seq, rx[cursor + 4],
+                                 rx[cursor + HEADER_SIZE:end]))
+                self.expected = (seq + 1) & 0xFFFF
+            # else: duplicate or out of sequence, discard
+            cursor = end
+        return received
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Paxcounter SPI master")
+    parser.add_argument("--bus", type=int, default=0)
+    parser.add_argument("--device", type=int, default=0)
+    parser.add_argument("--speed", type=int, default=1000000)
+    parser.add_argument("--size", type=int, default=BUFFER_SIZE)
+    parser.add_argument("--interval", type=float, default=1.0,
+                        help="poll interval [seconds] when slave is idle")
+    parser.add_argument("--command", help="remote command to send, hex")
+    args = parser.parse_args()
+
+    import spidev
+    spi = spidev.SpiDev()
+    spi.open(args.bus, args.device)
+    spi.max_speed_hz = args.speed
+    spi.mode = 0
+
+    master = SpiMaster(lambda tx: spi.xfer2(list(tx)), args.size)
+    if args.command:
+        master.send_command(bytes.fromhex(args.command))
+
+    while True:
+        received = master.poll()
+        for seq, port, payload in received:
+            print("%5u %3u %s" % (seq, port, payload.hex()))
+        sys.stdout.flush()
+        # drain backlog back to back, otherwise wait
+        if not received:
+            time.sleep(args.interval)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+# Loopback test of the reference SPI master against a model of the slave
+# side of SPI protocol 2 (src/spislave.cpp), with bit errors and short
+# transactions injected in both directions.
+#
+# usage: python3 -m unittest test_spimaster   (run in src/SPI)
+
+import random
+import unittest
+
+import spimaster
+from spimaster import (FLAG_SYNC, HEADER_SIZE, PROTOCOL, RCMDPORT, SpiMaster,
+                       crc16, message)
+
+OUTBOX_SIZE = 16  # SEND_QUEUE_SIZE
+BUFFERS = 2
+
+
+class SlaveModel:
+    # mirrors spi_fetch(), spi_arm(), spi_ack() and spi_complete()
+
+    def __init__(self, size=spimaster.BUFFER_SIZE):
+        self.size = size
+        self.queue = []  # send queue, (port, payload)
+        self.outbox = []  # unacknowledged messages, oldest first
+        self.outbox_next = 0
+        self.outbox_seq = 0
+        self.clocked_seq = 0
+        self.epoch = 0
+        self.clocked_epoch = 0
+        self.seq_sync = True
+        self.armed = []  # armed buffers in driver order
+        self.commands = []
+
+    def fetch(self):
+        while self.queue and len(self.outbox) < OUTBOX_SIZE:
+            self.outbox.append(self.queue.pop(0))
+
+    def arm(self):
+        tx = bytearray(self.size)
+        cursor = HEADER_SIZE
+        seq = (self.outbox_seq + self.outbox_next) & 0xFFFF
+        ends = []
+        while self.outbox_next < len(self.outbox):
+            port, payload = self.outbox[self.outbox_next]
+            msg = message(seq + len(ends), port, payload)
+            if cursor + len(msg) > self.size:
+                break
+            tx[cursor:cursor + len(msg)] = msg
+            cursor += len(msg)
+            ends.append(cursor)
+            self.outbox_next += 1
+        tx[2:6] = bytes([PROTOCOL, len(ends),
+                         FLAG_SYNC if self.seq_sync else 0, 0])
+        crc = crc16(tx[2:6])
+        tx[0:2] = bytes([crc & 0xFF, crc >> 8])
+        self.armed.append({"tx": tx, "seq": seq, "ends": ends,
+                           "epoch": self.epoch})
+
+    def prepare(self):
+        # one pass of spi_slave_task() before the master clocks
+        self.fetch()
+        while (len(self.armed) < BUFFERS and
+               (self.outbox_next < len(self.outbox) or
+                (self.outbox and not self.armed))):
+            self.arm()
+
+    def ack(self, ack):
+        n = (ack + 1 - self.outbox_seq) & 0xFFFF
+        if n >= 0x8000:
+            n -= 0x10000
+        if n <= 0 or n > self.outbox_next:
+            return
+        del self.outbox[:n]
+        self.outbox_next -= n
+        self.outbox_seq = (self.outbox_seq + n) & 0xFFFF
+        self.seq_sync = False
+
+    def complete(self, sb, rx, clocked):
+        valid = (clocked >= HEADER_SIZE and rx[2] == PROTOCOL and
+                 (rx[0] | rx[1] << 8) == crc16(rx[2:6]))
+        if valid:
+            ack = rx[4] | rx[5] << 8
+            self.ack(ack)
+            behind = (self.clocked_seq - (ack + 1)) & 0xFFFF
+            if 0 < behind < 0x8000 and self.clocked_epoch == self.epoch:
+                self.outbox_next = 0
+                self.epoch += 1
+
+        sent = 0
+        while sent < len(sb["ends"]) and sb["ends"][sent] <= clocked:
+            sent += 1
+        if sent:
+            self.clocked_seq = (sb["seq"] + sent) & 0xFFFF
+
+        if sent < len(sb["ends"]) and sb["epoch"] == self.epoch:
+            n = (sb["seq"] + sent - self.outbox_seq) & 0xFFFF
+            if n < 0x8000 and n < self.outbox_next:
+                self.outbox_next = n
+                self.epoch += 1
+        self.clocked_epoch = sb["epoch"]
+
+        msg = rx[HEADER_SIZE:]
+        if valid and rx[3] and msg[4] == RCMDPORT:
+            size = msg[5]
+            if (2 * HEADER_SIZE + size <= clocked and
+                    (msg[0] | msg[1] << 8) ==
+                    crc16(msg[2:HEADER_SIZE + size])):
+                self.commands.append(bytes(msg[HEADER_SIZE:
+                                                HEADER_SIZE + size]))
+
+
+class Wire:
+    # clocks one transaction between master and slave, damaging it at the
+    # given rates
+
+    def __init__(self, slave, rng, bit_errors=0.0, short=0.0):
+        self.slave = slave
+        self.rng = rng
+        self.bit_errors = bit_errors
+        self.short = short
+
+    def damage(self, data, clocked):
+        data = bytearray(data)
+        if clocked and self.rng.random() < self.bit_errors:
+            bit = self.rng.randrange(clocked * 8)
+            data[bit // 8] ^= 1 << bit % 8
+        return data
+
+    def xfer(self, tx):
+        self.slave.prepare()
+        clocked = len(tx)
+        if self.rng.random() < self.short:
+            clocked = self.rng.randrange(len(tx))
+        if not self.slave.armed:
+            return bytes(clocked)  # no transaction queued, MISO idles low
+        sb = self.slave.armed.pop(0)
+        rx = self.damage(tx, clocked)
+        rx[clocked:] = bytes(len(rx) - clocked)
+        self.slave.complete(sb, rx, clocked)
+        return self.damage(sb["tx"], clocked)[:clocked]
+
+
+def payloads(rng, count):
+    return [(rng.randrange(1, 200), bytes(rng.randrange(256) for _ in
+                                          range(rng.randrange(1, 60))))
+            for _ in range(count)]
+
+
+def run(seed, count=300, bit_errors=0.0, short=0.0, polls=5000):
+    # feed count messages to the slave over time, return what the master got
+    rng = random.Random(seed)
+    slave = SlaveModel()
+    master = SpiMaster(Wire(slave, rng, bit_errors, short).xfer)
+    pending = payloads(rng, count)
+    received = []
+    for _ in range(polls):
+        for _ in range(rng.randrange(4)):
+            if pending:
+                slave.queue.append(pending.pop(0))
+        received += master.poll()
+        if not pending and not slave.queue and not slave.outbox:
+            break
+    return received
+
+
+class LoopbackTest(unittest.TestCase):
+
+    def check(self, seed, **damage):
+        rng = random.Random(seed)
+        sent = payloads(rng, 300)
+        received = run(seed, **damage)
+        self.assertEqual([(port, payload) for _, port, payload in received],
+                         sent, "seed %d" % seed)
+        self.assertEqual([seq for seq, _, _ in received],
+                         list(range(len(sent))), "seed %d" % seed)
+
+    def test_clean(self):
+        for seed in range(20):
+            self.check(seed)
+
+    def test_bit_errors(self):
+        for seed in range(50):
+            self.check(seed, bit_errors=0.2)
+
+    def test_short_transactions(self):
+        for seed in range(50):
+            self.check(seed, short=0.2)
+
+    def test_bit_errors_and_short_transactions(self):
+        for seed in range(50):
+            self.check(seed, bit_errors=0.1, short=0.1)
+
+    def test_command(self):
+        rng = random.Random(1)
+        slave = SlaveModel()
+        master = SpiMaster(Wire(slave, rng).xfer)
+        master.send_command(b"\x81")
+        master.send_command(b"\x02\x01")
+        # commands wait while the slave has no transaction armed
+        for _ in range(3):
+            master.poll()
+        self.assertEqual(slave.commands, [])
+        slave.queue += [(1, b"a"), (1, b"b"), (1, b"c")]
+        for _ in range(3):
+            master.poll()
+        self.assertEqual(slave.commands, [b"\x81", b"\x02\x01"])
+
+    def test_slave_restart(self):
+        # master resynchronizes on sequence numbers of a restarted slave
+        rng = random.Random(2)
+        slave = SlaveModel()
+        wire = Wire(slave, rng)
+        master = SpiMaster(wire.xfer)
+        slave.queue += [(1, b"a"), (1, b"b")]
+        # messages, acknowledge, then the idle slave ends the sync run
+        got = master.poll() + master.poll() + master.poll()
+        wire.slave = slave = SlaveModel()
+        slave.queue += [(1, b"c")]
+        got += master.poll() + master.poll()
+        self.assertEqual([(seq, payload) for seq, _, payload in got],
+                         [(0, b"a"), (1, b"b"), (0, b"c")])
+
+
+if __name__ == "__main__":
+    unittest.main()
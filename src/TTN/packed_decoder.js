@@ -41,6 +41,14 @@ function Decoder(bytes, port) {
         if (bytes.length === 20) {
             return decode(bytes, [uint16, uptime, uint8, uint32, uint8, uint32], ['voltage', 'uptime', 'cputemp', 'memory', 'reset0', 'restarts']);
         }
+        // extended device status, send statistics of a transport
+        if (bytes.length === 44) {
+            return decode(bytes, [uint8, uint32, uint16, uint16, uint16, uint8, histogram, histogram], ['transport', 'sent', 'drops', 'retries', 'toolarge', 'queue_hwm', 'wait', 'latency']);
+        }
+        // extended device status, deep sleep clock
+        if (bytes.length === 15) {
+            return decode(bytes, [uint8, int32, uint16, uint32, int32], ['page', 'sleep_ppm', 'sleep_samples', 'sleep_secs', 'sleep_residual']);
+        }
     }
 
     if (port === 3) {
@@ -84,6 +92,11 @@ function Decoder(bytes, port) {
         }
     }
 
+    if (port === 13) {
+        // task and heap telemetry
+        return telemetry(bytes);
+    }
+
 }
 
 
@@ -196,6 +209,34 @@ var altitude = function (bytes) {
 };
 altitude.BYTES = int16.BYTES;
 
+var histogram = function (bytes) {
+    // 8 buckets, uint16 each
+    var buckets = [];
+    for (var i = 0; i < histogram.BYTES; i += uint16.BYTES) {
+        buckets.push(uint16(bytes.slice(i, i + uint16.BYTES)));
+    }
+    return buckets;
+};
+histogram.BYTES = 8 * uint16.BYTES;
+
+var telemetry = function (bytes) {
+    // heap in 16 byte units, then id, cpu load, stack high-water mark per task
+    var decoded = {
+        heap_min: uint16(bytes.slice(0, 2)) * 16,
+        heap_block: uint16(bytes.slice(2, 4)) * 16,
+        heap_trend: int16(bytes.slice(4, 6)) * 16,
+        block_trend: int16(bytes.slice(6, 8)) * 16,
+        tasks: {}
+    };
+    for (var i = 8; i + 3 <= bytes.length; i += 3) {
+        decoded.tasks[bytes[i]] = {
+            cpu: bytes[i + 1] === 255 ? null : bytes[i + 1] / 2,
+            stack: bytes[i + 2] * 16
+        };
+    }
+    return decoded;
+};
+
 
 var float = function (bytes) {
     if (bytes.length !== float.BYTES) {
@@ -26,13 +26,39 @@ function Decoder(bytes, port) {
 
   if (port === 2) {
     var i = 0;
-    decoded.battery = ((bytes[i++] << 8) | bytes[i++]);
-    decoded.uptime = ((bytes[i++] << 56) | (bytes[i++] << 48) | (bytes[i++] << 40) | (bytes[i++] << 32) |
-      (bytes[i++] << 24) | (bytes[i++] << 16) | (bytes[i++] << 8) | bytes[i++]);
-    decoded.temp = bytes[i++];
-    decoded.memory = ((bytes[i++] << 24) | (bytes[i++] << 16) | (bytes[i++] << 8) | bytes[i++]);
-    decoded.reset0 = bytes[i++];
-    decoded.restarts = ((bytes[i++] << 24) | (bytes[i++] << 16) | (bytes[i++] << 8) | bytes[i++]);
+    if (bytes.length === 44) {
+      // extended device status, send statistics of a transport
+      decoded.transport = bytes[i++];
+      decoded.sent = ((bytes[i++] << 24) | (bytes[i++] << 16) | (bytes[i++] << 8) | bytes[i++]);
+      decoded.drops = (bytes[i++] << 8) | bytes[i++];
+      decoded.retries = (bytes[i++] << 8) | bytes[i++];
+      decoded.toolarge = (bytes[i++] << 8) | bytes[i++];
+      decoded.queue_hwm = bytes[i++];
+      decoded.wait = [];
+      for (var b = 0; b < 8; b++) {
+        decoded.wait.push((bytes[i++] << 8) | bytes[i++]);
+      }
+      decoded.latency = [];
+      for (var b = 0; b < 8; b++) {
+        decoded.latency.push((bytes[i++] << 8) | bytes[i++]);
+      }
+    } else if (bytes.length === 15) {
+      // extended device status, deep sleep clock
+      decoded.page = bytes[i++];
+      decoded.sleep_ppm = ((bytes[i++] << 24) | (bytes[i++] << 16) | (bytes[i++] << 8) | bytes[i++]);
+      decoded.sleep_samples = (bytes[i++] << 8) | bytes[i++];
+      decoded.sleep_secs = ((bytes[i++] << 24) | (bytes[i++] << 16) | (bytes[i++] << 8) | bytes[i++]);
+      decoded.sleep_residual = ((bytes[i++] << 24) | (bytes[i++] << 16) | (bytes[i++] << 8) | bytes[i++]);
+    } else {
+      // device status data
+      decoded.battery = ((bytes[i++] << 8) | bytes[i++]);
+      decoded.uptime = ((bytes[i++] << 56) | (bytes[i++] << 48) | (bytes[i++] << 40) | (bytes[i++] << 32) |
+        (bytes[i++] << 24) | (bytes[i++] << 16) | (bytes[i++] << 8) | bytes[i++]);
+      decoded.temp = bytes[i++];
+      decoded.memory = ((bytes[i++] << 24) | (bytes[i++] << 16) | (bytes[i++] << 8) | bytes[i++]);
+      decoded.reset0 = bytes[i++];
+      decoded.restarts = ((bytes[i++] << 24) | (bytes[i++] << 16) | (bytes[i++] << 8) | bytes[i++]);
+    }
   }
 
   if (port === 4) {
@@ -77,6 +103,22 @@ function Decoder(bytes, port) {
     }
   }
 
+  if (port === 13) {
+    // task and heap telemetry, memory in 16 byte units
+    var i = 0;
+    decoded.heap_min = ((bytes[i++] << 8) | bytes[i++]) * 16;
+    decoded.heap_block = ((bytes[i++] << 8) | bytes[i++]) * 16;
+    decoded.heap_trend = ((bytes[i++] << 24 | bytes[i++] << 16) >> 16) * 16;
+    decoded.block_trend = ((bytes[i++] << 24 | bytes[i++] << 16) >> 16) * 16;
+    decoded.tasks = {};
+    for (; i + 3 <= bytes.length; i += 3) {
+      decoded.tasks[bytes[i]] = {
+        cpu: bytes[i + 1] === 255 ? null : bytes[i + 1] / 2,
+        stack: bytes[i + 2] * 16
+      };
+    }
+  }
+
   if (port === 10) {
     var i = 0;
     if (bytes.length >= 2) {
@@ -5,7 +5,7 @@
 
 bmeStatus_t bme_status = {0, 0, 0, 0, 0, 0, 0, 0};
 
-Ticker bmecycler;
+JobTimer bmecycler;
 
 #define SEALEVELPRESSURE_HPA (1013.25)
 
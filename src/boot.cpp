@@ -82,13 +82,13 @@ void start_boot_menu(void) {
 
   // setup restart handle task for resetting ESP32, which is callable from ISR
   // (because esp_restart() from ISR would trigger the ESP32 task watchdog)
-  xTaskCreate(
+  TASK_CREATE(
       [](void *p) {
         vTaskSuspend(NULL); // wait for task resume call by watchdog
         esp_restart();
       },
       "Restart", configMINIMAL_STACK_SIZE, NULL, (3 | portPRIVILEGE_BIT),
-      &RestartHandle);
+      &RestartHandle, tskNO_AFFINITY);
 
   // setup watchdog, based on esp32 timer2 interrupt
   wdTimer = timerBegin(0, 80, true);              // timer 0, div 80, countup
@@ -24,28 +24,54 @@ void longPressStart(void) {
   SendPayload(BUTTONPORT);
 }
 
+// button pin changed, wake up buttonloop, which polls until button is idle
+void IRAM_ATTR ButtonIRQ(void) {
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  gpio_intr_disable((gpio_num_t)HAS_BUTTON);
+  vTaskNotifyGiveFromISR(buttonLoopTask, &xHigherPriorityTaskWoken);
+  if (xHigherPriorityTaskWoken)
+    portYIELD_FROM_ISR();
+}
+
 void buttonLoop(void *parameter) {
   while (1) {
-    doIRQ(BUTTON_IRQ);
-    delay(50); // 50 is debounce time of OneButton lib, so doesn't hurt
+    // sleep until button is touched
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    // poll while button is pressed or a click is being detected
+    do {
+      doIRQ(BUTTON_IRQ);
+      delay(50); // 50 is debounce time of OneButton lib, so doesn't hurt
+    } while (!button.isIdle());
+    gpio_intr_enable((gpio_num_t)HAS_BUTTON);
   }
 }
 
 void button_init(void) {
   ESP_LOGI(TAG, "Starting button Controller...");
-  xTaskCreatePinnedToCore(buttonLoop,      // task function
-                          "buttonloop",    // name of task
-                          2048,            // stack size of task
-                          (void *)1,       // parameter of the task
-                          2,               // priority of the task
-                          &buttonLoopTask, // task handle
-                          1);              // CPU core
+  TASK_CREATE(buttonLoop,      // task function
+              "buttonloop",    // name of task
+              2048,            // stack size of task
+              (void *)1,       // parameter of the task
+              2,               // priority of the task
+              &buttonLoopTask, // task handle
+              1);              // CPU core
 
   button.setPressMs(1000);
   button.attachClick(singleClick);
   button.attachLongPressStart(longPressStart);
 
-  attachInterrupt(digitalPinToInterrupt(HAS_BUTTON), readButton, CHANGE);
+#if (POWER_MANAGEMENT)
+  // edges are lost in light sleep, so trigger on active level, which also
+  // wakes up from light sleep
+  attachInterrupt(digitalPinToInterrupt(HAS_BUTTON), ButtonIRQ,
+                  BUTTON_ACTIVEHIGH ? ONHIGH : ONLOW);
+  gpio_wakeup_enable((gpio_num_t)HAS_BUTTON,
+                     BUTTON_ACTIVEHIGH ? GPIO_INTR_HIGH_LEVEL
+                                       : GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+#else
+  attachInterrupt(digitalPinToInterrupt(HAS_BUTTON), ButtonIRQ, CHANGE);
+#endif
 };
 
 #endif
\ No newline at end of file
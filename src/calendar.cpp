@@ -0,0 +1,257 @@
+// Basic Config
+#include "globals.h"
+#include "calendar.h"
+
+const char cal_wday_names[7][4] = {"Sun", "Mon", "Tue", "Wed",
+                                   "Thu", "Fri", "Sat"};
+const char cal_month_names[12][4] = {"Jan", "Feb", "Mar", "Apr",
+                                     "May", "Jun", "Jul", "Aug",
+                                     "Sep", "Oct", "Nov", "Dec"};
+
+// date y-m-d of days since 1970-01-01
+void civil_from_days(int32_t z, int32_t *y, uint32_t *m, uint32_t *d) {
+  z += 719468;
+  const int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const uint32_t doe = (uint32_t)(z - era * 146097);
+  const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const uint32_t mp = (5 * doy + 2) / 153;
+  *d = doy - (153 * mp + 2) / 5 + 1;
+  *m = mp < 10 ? mp + 3 : mp - 9;
+  *y = (int32_t)yoe + era * 400 + (*m <= 2);
+}
+
+// struct tm (UTC) to epoch, fields must be normalized
+time_t cal_mkgmtime(const struct tm *tm) {
+  return (time_t)days_from_civil(tm->tm_year + 1900, tm->tm_mon + 1,
+                                 tm->tm_mday) *
+             SECS_PER_DAY +
+         tm->tm_hour * 3600 + tm->tm_min * 60 + tm->tm_sec;
+}
+
+// epoch to struct tm (UTC)
+void cal_gmtime(time_t t, struct tm *tm) {
+  int32_t days = t / SECS_PER_DAY, secs = t % SECS_PER_DAY, y;
+  uint32_t m, d;
+  if (secs < 0) {
+    secs += SECS_PER_DAY;
+    days--;
+  }
+  civil_from_days(days, &y, &m, &d);
+  tm->tm_year = y - 1900;
+  tm->tm_mon = m - 1;
+  tm->tm_mday = d;
+  tm->tm_hour = secs / 3600;
+  tm->tm_min = secs / 60 % 60;
+  tm->tm_sec = secs % 60;
+  tm->tm_wday = weekday_from_days(days);
+  tm->tm_yday = days - days_from_civil(y, 1, 1);
+  tm->tm_isdst = 0;
+}
+
+/* POSIX TZ rule, e.g. "CET-1CEST,M3.5.0/2,M10.5.0/3"
+
+  std offset [dst [offset] [,start[/time],end[/time]]]
+
+offsets are west of UTC, rules are Mm.w.d (d'th day of week w of month m,
+w = 5 is the last), Jn (day 1..365 ignoring feb 29) or n (day 0..365).
+*/
+
+enum tzrule_t { TZ_MWD, TZ_JULIAN1, TZ_JULIAN0 };
+
+typedef struct {
+  tzrule_t type;
+  uint16_t m, w, d; // month, week and weekday, or day for julian rules
+  int32_t time;     // local time of transition [sec]
+} tzRule_t;
+
+static struct {
+  int32_t std_west, dst_west; // offsets west of UTC [sec]
+  bool has_dst;
+  tzRule_t start, end;
+} tz = {0, 0, false, {TZ_MWD, 0, 0, 0, 0}, {TZ_MWD, 0, 0, 0, 0}};
+
+// cache of offset, valid from .. until, shared by all tasks showing local
+// time, so it is only copied in and out under tz_mux
+typedef struct {
+  time_t from, until;
+  int32_t offset;
+  bool isdst;
+} tzCache_t;
+
+static tzCache_t tz_cache = {1, 0, 0, false};
+static portMUX_TYPE tz_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *tz_name(const char *p) {
+  if (*p == '<') {
+    while (*p && *p != '>')
+      p++;
+    return *p ? p + 1 : NULL;
+  }
+  const char *s = p;
+  while (isalpha(*p))
+    p++;
+  return (p - s >= 3) ? p : NULL;
+}
+
+// [+-]hh[:mm[:ss]]
+static const char *tz_time(const char *p, int32_t *secs) {
+  int32_t sign = 1, h = 0, m = 0, s = 0;
+  if (*p == '+' || *p == '-')
+    sign = (*p++ == '-') ? -1 : 1;
+  if (!isdigit(*p))
+    return NULL;
+  h = strtol(p, (char **)&p, 10);
+  if (*p == ':') {
+    m = strtol(p + 1, (char **)&p, 10);
+    if (*p == ':')
+      s = strtol(p + 1, (char **)&p, 10);
+  }
+  *secs = sign * (h * 3600 + m * 60 + s);
+  return p;
+}
+
+static const char *tz_rule(const char *p, tzRule_t *r) {
+  if (*p == 'M') {
+    r->type = TZ_MWD;
+    r->m = strtol(p + 1, (char **)&p, 10);
+    if (*p++ != '.')
+      return NULL;
+    r->w = strtol(p, (char **)&p, 10);
+    if (*p++ != '.')
+      return NULL;
+    r->d = strtol(p, (char **)&p, 10);
+    if (r->m < 1 || r->m > 12 || r->w < 1 || r->w > 5 || r->d > 6)
+      return NULL;
+  } else if (*p == 'J') {
+    r->type = TZ_JULIAN1;
+    r->d = strtol(p + 1, (char **)&p, 10);
+  } else if (isdigit(*p)) {
+    r->type = TZ_JULIAN0;
+    r->d = strtol(p, (char **)&p, 10);
+  } else
+    return NULL;
+  r->time = 7200; // default 02:00:00
+  if (*p == '/')
+    p = tz_time(p + 1, &r->time);
+  return p;
+}
+
+// parse POSIX TZ string, returns false and keeps UTC if malformed
+bool cal_settz(const char *s) {
+  const char *p = tz_name(s);
+
+  tz.std_west = tz.dst_west = 0;
+  tz.has_dst = false;
+  portENTER_CRITICAL(&tz_mux);
+  tz_cache.from = 1; // invalidate cache
+  tz_cache.until = 0;
+  portEXIT_CRITICAL(&tz_mux);
+
+  if (!p || !(p = tz_time(p, &tz.std_west)))
+    goto Fail;
+  tz.dst_west = tz.std_west;
+  if (!*p)
+    return true; // no DST
+
+  if (!(p = tz_name(p)))
+    goto Fail;
+  tz.dst_west = tz.std_west - 3600;
+  if (*p && *p != ',' && !(p = tz_time(p, &tz.dst_west)))
+    goto Fail;
+  if (*p++ != ',' || !(p = tz_rule(p, &tz.start)) || *p++ != ',' ||
+      !(p = tz_rule(p, &tz.end)))
+    goto Fail;
+  tz.has_dst = true;
+  return true;
+
+Fail:
+  tz.std_west = tz.dst_west = 0;
+  ESP_LOGW(TAG, "Timezone '%s' not understood, using UTC", s);
+  return false;
+}
+
+// UTC time of a DST transition in year y, local time is offset by west
+static time_t tz_transition(int32_t y, const tzRule_t *r, int32_t west) {
+  int32_t days;
+  switch (r->type) {
+  case TZ_JULIAN1: // 1..365, feb 29 never counted
+    days = days_from_civil(y, 1, 1) + r->d - 1 +
+           ((is_leap(y) && r->d >= 60) ? 1 : 0);
+    break;
+  case TZ_JULIAN0: // 0..365
+    days = days_from_civil(y, 1, 1) + r->d;
+    break;
+  default: { // d'th weekday in week w of month m, week 5 is last
+    int32_t first = days_from_civil(y, r->m, 1);
+    uint32_t mday = 1 + (r->d + 7 - weekday_from_days(first)) % 7 +
+                    (r->w - 1) * 7;
+    if (mday > last_day_of_month(y, r->m))
+      mday -= 7;
+    days = first + mday - 1;
+  }
+  }
+  return (time_t)days * SECS_PER_DAY + r->time + west;
+}
+
+// offset of local time to UTC at time t [sec], positive east of UTC
+int32_t cal_utcoffset(time_t t, bool *isdst) {
+  tzCache_t c;
+  portENTER_CRITICAL(&tz_mux);
+  c = tz_cache;
+  portEXIT_CRITICAL(&tz_mux);
+
+  if (t < c.from || t >= c.until) {
+    if (!tz.has_dst) {
+      c.from = INT32_MIN;
+      c.until = INT32_MAX;
+      c.isdst = false;
+    } else {
+      // transitions of the year around t, start is in standard time, end in
+      // daylight saving time
+      struct tm tm;
+      cal_gmtime(t - tz.std_west, &tm);
+      int32_t y = tm.tm_year + 1900;
+      time_t y_from =
+          (time_t)days_from_civil(y, 1, 1) * SECS_PER_DAY + tz.std_west;
+      time_t y_until =
+          (time_t)days_from_civil(y + 1, 1, 1) * SECS_PER_DAY + tz.std_west;
+      time_t start = tz_transition(y, &tz.start, tz.std_west);
+      time_t end = tz_transition(y, &tz.end, tz.dst_west);
+      time_t first = min(start, end), second = max(start, end);
+
+      // which of the three periods of the year are we in?
+      if (t < first) {
+        c.from = y_from;
+        c.until = first;
+        c.isdst = (start > end); // southern hemisphere: dst at new year
+      } else if (t < second) {
+        c.from = first;
+        c.until = second;
+        c.isdst = (start < end);
+      } else {
+        c.from = second;
+        c.until = y_until;
+        c.isdst = (start > end);
+      }
+    }
+    c.offset = -(c.isdst ? tz.dst_west : tz.std_west);
+
+    portENTER_CRITICAL(&tz_mux);
+    tz_cache = c;
+    portEXIT_CRITICAL(&tz_mux);
+    ESP_LOGD(TAG, "Timezone: UTC%+d sec%s until %ld", c.offset,
+             c.isdst ? " (DST)" : "", (long)c.until);
+  }
+  if (isdst)
+    *isdst = c.isdst;
+  return c.offset;
+}
+
+// epoch to struct tm in local time
+void cal_localtime(time_t t, struct tm *tm) {
+  bool isdst;
+  int32_t offset = cal_utcoffset(t, &isdst);
+  cal_gmtime(t + offset, tm);
+  tm->tm_isdst = isdst;
+}
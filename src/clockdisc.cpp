@@ -0,0 +1,239 @@
+// Basic Config
+#include "clockdisc.h"
+#include "timefusion.h"
+
+/* clock discipline for time syncs from network
+
+Each sync delivers a set of offset samples (reference time - system time).
+Outliers are rejected by median and median absolute deviation, the remaining
+samples are averaged and weighed against system time, see timefusion.cpp.
+Small corrections are slewed by adjtime(), large ones step the clock.
+
+The offsets of the past syncs, together with the corrections we applied to
+the system clock, give the offset of the uncorrected clock over time. A
+linear regression over them estimates the drift of the ESP32 clock, which is
+compensated in the housekeeping cycle. As the drift estimate settles the
+remaining offsets get small, and the sync interval is doubled up to
+TIME_SYNC_INTERVAL_MAX minutes. It is halved again if an offset exceeds
+TIME_SYNC_TOLERANCE.
+*/
+
+typedef struct {
+  int64_t uptime; // [ms] monotonic time of sync
+  int64_t offset; // [ms] offset of uncorrected clock to reference
+} clockSample_t;
+
+static clockSample_t history[CLOCK_HISTORY];
+static uint8_t hist_count = 0, hist_next = 0;
+
+static int64_t applied = 0;    // [ms] corrections applied to system clock
+static float drift = 0;        // [ppm] estimated drift of system clock
+static float drift_error = TIME_DRIFT_SYS; // [ppm] error of drift estimate
+static float drift_rest = 0;   // [ms] drift not yet applied
+static int64_t drift_last = 0; // [ms] uptime drift was applied last
+static uint32_t interval = TIME_SYNC_INTERVAL; // [minutes]
+#ifdef HAS_RTC
+static bool rtc_due = false; // set RTC from system time when slew finished
+#endif
+
+static int64_t uptime_ms(void) { return esp_timer_get_time() / 1000LL; }
+
+// offset of reference time t_sec.t_msec, taken now, to system time [ms]
+int64_t clock_offset(uint32_t t_sec, int32_t t_msec) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return ((int64_t)t_sec - now.tv_sec) * 1000LL + t_msec -
+         now.tv_usec / 1000;
+}
+
+// slew system clock, adding to a slew which may be still in progress
+static void clock_slew(int64_t ms) {
+  struct timeval delta, rest;
+  adjtime(NULL, &rest);
+  int64_t us = rest.tv_sec * 1000000LL + rest.tv_usec + ms * 1000LL;
+  delta.tv_sec = us / 1000000LL;
+  delta.tv_usec = us % 1000000LL;
+  adjtime(&delta, NULL);
+}
+
+// shift software pps to top of second of the corrected system time
+static void clock_align_pps(int64_t ms) {
+  if (ppsIRQ == NULL)
+    return;
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  int64_t frac = (now.tv_usec / 1000 + ms) % 1000;
+  if (frac < 0)
+    frac += 1000;
+  timerWrite(ppsIRQ, frac * 10); // timer runs with 1/10000 sec
+}
+
+// mean of samples, ignoring outliers by median absolute deviation
+static bool clock_filter(const int64_t offsets[], uint8_t count,
+                         int64_t *mean, uint32_t *spread) {
+  // static, up to 4 KB would not fit on stack of timesync task, which is the
+  // only caller
+  static int64_t sorted[TIME_SYNC_SAMPLES], dev[TIME_SYNC_SAMPLES];
+
+  if (!count)
+    return false;
+  count = min(count, (uint8_t)TIME_SYNC_SAMPLES);
+
+  memcpy(sorted, offsets, count * sizeof(int64_t));
+  std::sort(sorted, sorted + count);
+  int64_t median = sorted[count / 2];
+  for (int i = 0; i < count; i++)
+    dev[i] = llabs(offsets[i] - median);
+  std::sort(dev, dev + count);
+  // scale MAD to standard deviation of normal distribution
+  float sigma = 1.4826 * dev[count / 2];
+  float limit = max(CLOCK_MAD_LIMIT * sigma, (double)CLOCK_MAD_FLOOR);
+
+  int64_t sum = 0;
+  uint8_t used = 0;
+  for (int i = 0; i < count; i++)
+    if (llabs(offsets[i] - median) <= limit) {
+      sum += offsets[i] - median;
+      used++;
+    }
+  *mean = median + sum / used; // used >= 1, median itself is within limit
+  *spread = (uint32_t)(sigma / sqrt(used));
+  if (used < count)
+    ESP_LOGI(TAG, "Clock: %u of %u time samples rejected as outliers",
+             count - used, count);
+  return true;
+}
+
+// estimate drift by linear regression of offsets over time
+static void clock_regression(void) {
+  if (hist_count < 3)
+    return;
+
+  // values relative to oldest sample, to keep precision
+  const clockSample_t *base =
+      &history[(hist_next + CLOCK_HISTORY - hist_count) % CLOCK_HISTORY];
+  double sx = 0, sy = 0, sxx = 0, sxy = 0, syy = 0;
+  for (int i = 0; i < hist_count; i++) {
+    double x = history[i].uptime - base->uptime;
+    double y = history[i].offset - base->offset;
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+    syy += y * y;
+  }
+  double d = hist_count * sxx - sx * sx;
+  if (d <= 0)
+    return;
+  double slope = (hist_count * sxy - sx * sy) / d;
+  drift = slope * 1e6;
+
+  // standard error of slope, from residuals of the regression line
+  double ssr = (hist_count * syy - sy * sy) / hist_count -
+               slope * slope * d / hist_count;
+  double se = sqrt(max(ssr, 0.0) / (hist_count - 2) / (d / hist_count));
+  drift_error = constrain(3 * se * 1e6, (double)CLOCK_DRIFT_FLOOR,
+                          (double)TIME_DRIFT_SYS);
+  ESP_LOGI(TAG, "Clock: drift estimate %.2f +/- %.2f ppm over %u syncs", drift,
+           drift_error, hist_count);
+}
+
+// process offset samples of a sync, correct system clock
+bool clock_discipline(const int64_t offsets[], uint8_t count,
+                      timesource_t source) {
+  timeSample_t sample;
+  uint32_t spread;
+
+  if (!clock_filter(offsets, count, &sample.offset, &spread))
+    return false;
+
+  clock_drift_apply(); // bring drift compensation up to date
+
+  // record offset of the uncorrected clock
+  history[hist_next].uptime = uptime_ms();
+  history[hist_next].offset = sample.offset + applied;
+  hist_next = (hist_next + 1) % CLOCK_HISTORY;
+  if (hist_count < CLOCK_HISTORY)
+    hist_count++;
+  clock_regression();
+
+  // adapt sync interval to remaining offset
+  if (llabs(sample.offset) > TIME_SYNC_TOLERANCE)
+    interval = max(interval / 2, (uint32_t)TIME_SYNC_INTERVAL);
+  else if ((hist_count >= 3) &&
+           (llabs(sample.offset) <= TIME_SYNC_TOLERANCE / 2))
+    interval = min(interval * 2, (uint32_t)TIME_SYNC_INTERVAL_MAX);
+
+  ESP_LOGI(TAG, "Clock: offset %lld ms, next sync in %u min", sample.offset,
+           interval);
+
+  // weigh with system time by the spread of the answers
+  sample.error = max(spread, (uint32_t)TIME_ERROR_LORA);
+  sample.source = source;
+  return time_fuse(&sample, 1);
+}
+
+// correct system clock by offset: step if it was never synced or is far off,
+// otherwise slew it
+bool clock_adjust(int64_t offset, timesource_t source) {
+  if ((timeSource == _unsynced) || (timeSource == _set) ||
+      (llabs(offset) > TIME_SYNC_STEP)) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    int64_t ref = now.tv_sec * 1000LL + now.tv_usec / 1000 + offset;
+    if (!setMyTime(ref / 1000, ref % 1000, source))
+      return false;
+  } else {
+    clock_slew(offset);
+    clock_align_pps(offset);
+    timeSource = source;
+#ifdef HAS_RTC
+    // system time is not yet corrected, and we may run with irqs masked
+    if ((source == _gps) || (source == _lora))
+      rtc_due = true;
+#endif
+    timesyncer.attach(clock_syncinterval() * 60, setTimeSyncIRQ);
+  }
+  applied += offset;
+  return true;
+}
+
+// compensate estimated drift, called cyclic
+void clock_drift_apply(void) {
+  int64_t now = uptime_ms();
+
+  if ((timeSource != _unsynced) && (timeSource != _set) && drift != 0) {
+    drift_rest += drift * (now - drift_last) / 1e6;
+    int32_t ms = drift_rest; // apply whole milliseconds only
+    if (ms) {
+      clock_slew(ms);
+      applied += ms;
+      drift_rest -= ms;
+    }
+  }
+  drift_last = now;
+}
+
+// current sync interval [minutes]
+uint32_t clock_syncinterval(void) { return interval; }
+
+float clock_drift_ppm(void) { return drift; }
+
+// drift of system clock remaining after compensation [ppm]
+float clock_drift_error(void) {
+  return (drift != 0) ? drift_error : TIME_DRIFT_SYS;
+}
+
+// set RTC to a slewed system time once adjtime() has finished, called cyclic
+void clock_rtc_sync(void) {
+#ifdef HAS_RTC
+  struct timeval rest;
+  if (!rtc_due)
+    return;
+  adjtime(NULL, &rest);
+  if (rest.tv_sec || llabs(rest.tv_usec) >= 1000)
+    return;
+  rtc_due = false;
+  sync_rtctime();
+#endif
+}
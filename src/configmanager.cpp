@@ -50,6 +50,13 @@ static void defaultConfig(configData_t *myconfig) {
   myconfig->rgblum = RGBLUMINOSITY; // RGB Led luminosity (0..100%)
   myconfig->payloadmask = PAYLOADMASK; // payloads as defined in default
 
+  // send payload of all ports on all transports, no failover
+  for (int i = 0; i < ROUTE_PORTS; i++) {
+    myconfig->portroute[i].transports = PORTROUTE_DEFAULT;
+    myconfig->portroute[i].fallback = 0;
+    myconfig->portroute[i].failover = 0;
+  }
+
 #ifdef HAS_BME680
   // initial BSEC state for BME680 sensor
   myconfig->bsecstate[BSEC_MAX_STATE_BLOB_SIZE] = {0};
@@ -5,7 +5,9 @@
 #include "cyclic.h"
 
 
-Ticker cyclicTimer;
+JobTimer cyclicTimer;
+
+static uint8_t heap_low = 0; // consecutive cycles with free heap exhausted
 
 void setCyclicIRQ() { xTaskNotify(irqHandlerTask, CYCLIC_IRQ, eSetBits); }
 
@@ -20,61 +22,14 @@ void doHousekeeping() {
            ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getHeapSize(),
            ESP.getMaxAllocHeap(), uxTaskGetStackHighWaterMark(NULL));
 
-  if (irqHandlerTask != NULL)
-    ESP_LOGD(TAG, "IRQhandler %d bytes left | Taskstate = %d",
-             uxTaskGetStackHighWaterMark(irqHandlerTask),
-             eTaskGetState(irqHandlerTask));
-  if (rcmdTask != NULL)
-    ESP_LOGD(TAG, "Rcommand interpreter %d bytes left | Taskstate = %d",
-             uxTaskGetStackHighWaterMark(rcmdTask), eTaskGetState(rcmdTask));
-
-#if (HAS_LORA)
-  if (lmicTask != NULL)
-    ESP_LOGD(TAG, "LMiCtask %d bytes left | Taskstate = %d",
-             uxTaskGetStackHighWaterMark(lmicTask), eTaskGetState(lmicTask));
-  if (lorasendTask != NULL)
-    ESP_LOGD(TAG, "Lorasendtask %d bytes left | Taskstate = %d",
-             uxTaskGetStackHighWaterMark(lorasendTask),
-             eTaskGetState(lorasendTask));
-#endif
-
-#if (HAS_GPS)
-  if (GpsTask != NULL)
-    ESP_LOGD(TAG, "Gpsloop %d bytes left | Taskstate = %d",
-             uxTaskGetStackHighWaterMark(GpsTask), eTaskGetState(GpsTask));
-#endif
-
-#ifdef HAS_SPI
-  if (spiTask != NULL)
-    ESP_LOGD(TAG, "spiloop %d bytes left | Taskstate = %d",
-             uxTaskGetStackHighWaterMark(spiTask), eTaskGetState(spiTask));
-#endif
-
-#ifdef HAS_MQTT
-  if (mqttTask != NULL)
-    ESP_LOGD(TAG, "MQTTloop %d bytes left | Taskstate = %d",
-             uxTaskGetStackHighWaterMark(mqttTask), eTaskGetState(mqttTask));
-#endif
-
-#if (defined HAS_DCF77 || defined HAS_IF482)
-  if (ClockTask != NULL)
-    ESP_LOGD(TAG, "Clockloop %d bytes left | Taskstate = %d",
-             uxTaskGetStackHighWaterMark(ClockTask), eTaskGetState(ClockTask));
-#endif
+  // sample stack, CPU and heap usage of tasks
+  telemetry_sample();
 
-#if (HAS_LED != NOT_A_PIN) || defined(HAS_RGB_LED)
-  if (ledLoopTask != NULL)
-    ESP_LOGD(TAG, "LEDloop %d bytes left | Taskstate = %d",
-             uxTaskGetStackHighWaterMark(ledLoopTask),
-             eTaskGetState(ledLoopTask));
-#endif
-
-#ifdef HAS_BUTTON
-  if (buttonLoopTask != NULL)
-    ESP_LOGD(TAG, "Buttonloop %d bytes left | Taskstate = %d",
-             uxTaskGetStackHighWaterMark(buttonLoopTask),
-             eTaskGetState(buttonLoopTask));
+#ifdef HAS_DISPLAY
+  dp_logStats();
 #endif
+  irq_logStats();
+  ESP_LOGD(TAG, "Jobtimer %u wakeups", JobTimer::wakeups(true));
 
 // read battery voltage into global variable
 #if (defined BAT_MEASURE_ADC || defined HAS_PMU || defined HAS_IP5306)
@@ -106,12 +61,36 @@ void doHousekeeping() {
 #endif
 
   // check free heap memory
-  if (ESP.getMinFreeHeap() <= MEM_LOW) {
+  heapState_t heap = telemetry_heapstate();
+  if (heap != HEAP_LOW)
+    heap_low = 0;
+  else if (heap_low < UINT8_MAX)
+    heap_low++;
+  switch (heap) {
+  case HEAP_LEAK:
+    ESP_LOGW(TAG, "Memory leak, free heap = %d bytes, falling steadily",
+             ESP.getFreeHeap());
+    do_reset(true); // memory leak, reset device
+    break;
+  case HEAP_LOW: // not falling fast, may recover
     ESP_LOGW(TAG,
-             "Memory full, counter cleared (heap low water mark = %d Bytes / "
-             "free heap = %d bytes)",
+             "Memory low (heap low water mark = %d Bytes / free heap = %d "
+             "bytes), not falling",
              ESP.getMinFreeHeap(), ESP.getFreeHeap());
-    do_reset(true); // memory leak, reset device
+    // a slow leak, or one which stopped falling because allocations fail
+    if (heap_low >= HEAP_TREND_CYCLES) {
+      ESP_LOGW(TAG, "Memory low for %u cycles, counter cleared", heap_low);
+      do_reset(true); // memory exhausted, reset device
+    }
+    break;
+  case HEAP_FRAGMENTED: // warning only, see telemetry for block trend
+    ESP_LOGW(TAG,
+             "Heap fragmented, largest free block = %d bytes / free heap = %d "
+             "bytes",
+             ESP.getMaxAllocHeap(), ESP.getFreeHeap());
+    break;
+  default:
+    break;
   }
 
 // check free PSRAM memory
@@ -133,6 +112,15 @@ void doHousekeeping() {
 #if (HAS_SDCARD)
   sdcard_flush();
 #endif
+
+#ifdef HAS_RTC
+  clock_rtc_sync();
+#endif
+
+// compensate estimated clock drift between time syncs
+#if (HAS_LORA_TIME)
+  clock_drift_apply();
+#endif
 } // doHousekeeping()
 
 uint32_t getFreeRAM() {
@@ -14,31 +14,65 @@ https://github.com/udoklein/dcf77
 #include "dcf77.h"
 
 
-// triggered by second timepulse to ticker out DCF signal
-void DCF77_Pulse(uint8_t bit) {
-  TickType_t startTime;
-
-  // induce a DCF Pulse
-  for (uint8_t pulseLength = 0; pulseLength <= 2; pulseLength++) {
-    startTime = xTaskGetTickCount(); // reference time pulse start
-
-    switch (pulseLength) {
-    case 0: // 0ms = start of pulse
-      digitalWrite(HAS_DCF77, dcf_low);
-      break;
-    case 1: // 100ms = logic 0
-      if (bit == 0)
-        digitalWrite(HAS_DCF77, dcf_high);
-      break;
-    case 2: // 200ms = logic 1
-      digitalWrite(HAS_DCF77, dcf_high);
-      break;
-    } // switch
-
-    // delay to genrate pulseLength
-    vTaskDelayUntil(&startTime, pdMS_TO_TICKS(100));
-  } // for
-} // DCF77_Pulse()
+/* The frame of a minute is built ahead by the clock task, into one of two
+buffers, while the other one is clocked out. Output runs in interrupt
+context only: the pulse starts with the pps interrupt at top of second, and
+the 10ms clock tick interrupt ends it after 100ms (logic 0) or 200ms (logic
+1). The frame sent in minute m carries the time of minute m+1. Second 59
+has no pulse, marking the start of the next minute. */
+
+static DRAM_ATTR uint64_t dcf_frame[2];  // frames, indexed by minute & 1
+static DRAM_ATTR uint32_t dcf_minute[2]; // UTC minute each frame is sent in
+static DRAM_ATTR uint8_t dcf_pulse = 0;  // tick which ends current pulse
+
+static inline void IRAM_ATTR dcf_write(uint8_t level) {
+  gpio_ll_set_level(&GPIO, (gpio_num_t)HAS_DCF77, level);
+}
+
+// build frame for the minute following second t, if not yet done
+void DCF77_Schedule(time_t t) {
+  uint32_t m = t / 60 + 1; // minute the frame will be sent in
+  struct tm tt;
+
+  if (dcf_minute[m & 1] == m)
+    return;
+
+  // time of the minute after sending
+  cal_localtime((time_t)(m + 1) * 60, &tt);
+  uint64_t frame = DCF77_Frame(tt);
+
+  // announce DST change during the hour before it
+  if (cal_utcoffset((time_t)(m + 1) * 60) !=
+      cal_utcoffset((time_t)(m + 1) * 60 + 3600))
+    frame |= set_dcfbit(16);
+
+  // buffer is not in use by interrupt, which sends minute m - 1 now
+  dcf_frame[m & 1] = frame;
+  dcf_minute[m & 1] = m;
+
+  ESP_LOGD(TAG, "[%0.3f] DCF77: frame %016llx for %02d:%02d", _seconds(),
+           frame, tt.tm_hour, tt.tm_min);
+}
+
+// top of second t, called by pps interrupt
+void IRAM_ATTR DCF77_Second(time_t t) {
+  uint32_t m = t / 60, s = t % 60;
+
+  dcf_pulse = 0;
+  if ((dcf_minute[m & 1] != m) || (s == 59))
+    return; // no recent frame, or minute mark
+
+  dcf_write(dcf_low); // start pulse
+  dcf_pulse = (dcf_frame[m & 1] >> s) & 1 ? DCF77_TICKS_1 : DCF77_TICKS_0;
+}
+
+// clock tick since top of second, called by 10ms timer interrupt
+void IRAM_ATTR DCF77_Tick(uint8_t tick) {
+  if (dcf_pulse && (tick == dcf_pulse)) {
+    dcf_write(dcf_high); // end pulse
+    dcf_pulse = 0;
+  }
+}
 
 // helper function to convert decimal to bcd digit
 uint64_t dec2bcd(uint8_t const dec, uint8_t const startpos,
@@ -37,7 +37,6 @@ MY_FONT_LARGE:     16x32px = 8 chars / line @ 2 lines
 #include "globals.h"
 #include "display.h"
 
-static uint8_t plotbuf[PLOTBUFFERSIZE] = {0};
 uint8_t DisplayIsOn = 0;
 hw_timer_t *displayIRQ = NULL;
 static QRCode qrcode;
@@ -62,6 +61,156 @@ BB_SPI_LCD *dp = NULL;
 #define DISPLAY_PAGE_PAX_GRAPH          6
 #define DISPLAY_PAGE_BLANK_SCREEN       7
 
+#define DP_MODEL_SIZE 12 // max. number of values shown on a page
+
+// display load statistics, see dp_logStats()
+static struct {
+  uint32_t frames;  // refresh cycles
+  uint32_t renders; // refresh cycles with changed content
+  uint32_t bytes;   // bytes transferred to display
+  uint32_t cpu_us;  // time spent in dp_refresh
+} dp_stats = {0};
+
+static uint8_t graph_zoom = PAXGRAPH_ZOOMS - 1; // steps on each graph page visit
+
+#if (HAS_DISPLAY) > 1
+// TFT frame buffer is transferred by a low priority task, so that the
+// irqHandler task is not blocked during the SPI transfer
+TaskHandle_t dpFlushTask = NULL;
+static volatile bool dp_flushing = false;
+
+static void dp_flushloop(void *pvParameters) {
+  _ASSERT((uint32_t)pvParameters == 1); // FreeRTOS check
+
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    dp->display();
+    dp_flushing = false;
+  }
+}
+#endif
+
+// wait until frame buffer may be written again
+static void dp_wait(void) {
+#if (HAS_DISPLAY) > 1
+  while (dp_flushing)
+    delay(1);
+#endif
+}
+
+// transfer frame buffer to display
+static void dp_flush(void) {
+#if (HAS_DISPLAY) > 1
+  if (dpFlushTask != NULL) {
+    dp_flushing = true;
+    xTaskNotifyGive(dpFlushTask);
+  } else
+    dp->display();
+#else
+  dp->display();
+#endif
+  dp_stats.bytes += DP_FRAME_BYTES;
+}
+
+// reinterpret float value for change detection
+static inline uint32_t dp_float(float f) {
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+// hash of a string for change detection
+static uint32_t dp_hash(const char *s) {
+  uint32_t h = 2166136261UL; // FNV-1a
+  while (*s)
+    h = (h ^ (uint8_t)*s++) * 16777619UL;
+  return h;
+}
+
+// collect values shown on a page, page is redrawn only if one of them changed
+static uint8_t dp_model(uint8_t page, const count_payload_t *count,
+                        uint32_t *m) {
+  uint8_t n = 0;
+
+  switch (page) {
+  case DISPLAY_PAGE_PAX_PARAM_OVERVIEW:
+    m[n++] = count->pax;
+    m[n++] = count->wifi_count;
+    m[n++] = count->ble_count;
+    m[n++] = cfg.wifiscan | cfg.blescan << 1 | cfg.adrmode << 2;
+#if (defined BAT_MEASURE_ADC || defined HAS_PMU || defined HAS_IP5306)
+    m[n++] = batt_level;
+#endif
+    m[n++] = channel;
+    m[n++] = cfg.rssilimit;
+    m[n++] = getFreeRAM() / 1024;
+#if (TIME_SYNC_INTERVAL)
+    m[n++] = time(NULL);
+    m[n++] = TimePulseTick ? ' ' : timeSetSymbols[timeSource];
+#endif
+#if (HAS_LORA)
+    m[n++] = dp_hash(lmic_event_msg);
+    m[n++] = LMIC.datarate;
+#endif
+    break;
+
+  case DISPLAY_PAGE_PAX_LORAWAN_PARAM:
+#if (HAS_LORA)
+    m[n++] = count->pax;
+    m[n++] = LMIC.netid;
+    m[n++] = LMIC.radio.txpow;
+    m[n++] = LMIC.devaddr;
+    m[n++] = LMIC.datarate;
+    m[n++] = LMIC.channelMap;
+    m[n++] = LMIC.devNonce;
+    m[n++] = LMIC.seqnoUp;
+    m[n++] = LMIC.seqnoDn;
+    m[n++] = LMIC.snr;
+    m[n++] = LMIC.rssi;
+#endif
+    break;
+
+  case DISPLAY_PAGE_PAX_GPS_LAT_LONG: {
+#if (HAS_GPS)
+    nmeaFix_t gpsfix;
+    gps_getfix(&gpsfix);
+    m[n++] = count->pax;
+    m[n++] = gpsfix.satellites;
+    m[n++] = gps_hasfix();
+    m[n++] = gpsfix.latitude;
+    m[n++] = gpsfix.longitude;
+#endif
+    break;
+  }
+
+  case DISPLAY_PAGE_BME280_680_VALUES:
+#if (HAS_BME)
+    m[n++] = dp_float(bme_status.temperature);
+    m[n++] = dp_float(bme_status.humidity);
+    m[n++] = dp_float(bme_status.pressure);
+    m[n++] = dp_float(bme_status.iaq);
+#endif
+    break;
+
+  case DISPLAY_PAGE_TIME_OF_DAY:
+    m[n++] = time(NULL);
+    m[n++] = uptime() / 100; // shown with 1/10 sec resolution
+    break;
+
+  case DISPLAY_PAGE_POWER_OVERVIEW:
+    // values are read and filtered while drawing, thus redraw each cycle
+    m[n++] = dp_stats.frames;
+    break;
+
+  case DISPLAY_PAGE_PAX_GRAPH:
+    m[n++] = graph_zoom;
+    m[n++] = paxgraph_revision();
+    break;
+  }
+
+  return n;
+}
+
 void dp_setup(int contrast) {
 #if (HAS_DISPLAY) == 1 // I2C OLED
 
@@ -144,6 +293,16 @@ void dp_init(bool verbose) {
   }    // verbose
 
   dp_power(cfg.screenon); // set display off if disabled
+
+#if (HAS_DISPLAY) > 1
+  TASK_CREATE(dp_flushloop,  // task function
+              "dpflush",     // name of task
+              4096,          // stack size of task
+              (void *)1,     // parameter of the task
+              1,             // priority of the task
+              &dpFlushTask,  // task handle
+              1);            // CPU core
+#endif
 } // dp_init
 
 // write display content to display buffer
@@ -151,22 +310,46 @@ void dp_init(bool verbose) {
 void dp_refresh(bool nextPage) {
   struct count_payload_t count; // libpax count storage
   static uint8_t DisplayPage = 0;
-  char timeState, strftime_buf[45];
+  static uint8_t shown_page = 0xff, shown_len = 0;
+  static uint32_t shown[DP_MODEL_SIZE]; // values currently on display
+  uint32_t model[DP_MODEL_SIZE];
+  uint8_t model_len;
+  const int64_t start_us = esp_timer_get_time();
+  char timeState;
   time_t now;
   struct tm timeinfo = {0};
+#if (HAS_GPS)
+  nmeaFix_t gpsfix;
+#endif
 #ifndef HAS_BUTTON
   static uint32_t framecounter = 0;
   const uint32_t flip_threshold = DISPLAYCYCLE * 1000 / DISPLAYREFRESH_MS;
 #endif
+#if (HAS_DISPLAY) > 1
+  static bool flip_pending = false;
+#endif
 
   // if display is switched off we don't refresh it to relax cpu
   if (!DisplayIsOn && (DisplayIsOn == cfg.screenon))
     return;
 
+  dp_stats.frames++;
+
+#if (HAS_DISPLAY) > 1
+  // previous frame still in transfer? then skip this cycle
+  if (dp_flushing) {
+    flip_pending |= nextPage;
+    return;
+  }
+  nextPage |= flip_pending;
+  flip_pending = false;
+#endif
+
   // set display on/off according to current device configuration
   if (DisplayIsOn != cfg.screenon) {
     DisplayIsOn = cfg.screenon;
     dp_power(cfg.screenon);
+    shown_page = 0xff; // redraw
   }
 
 #ifndef HAS_BUTTON
@@ -179,9 +362,28 @@ void dp_refresh(bool nextPage) {
 
   if (nextPage) {
     DisplayPage = (DisplayPage >= DISPLAY_PAGES - 1) ? 0 : (DisplayPage + 1);
-    dp_clear();
-  } else
-    dp->setCursor(0, 0);
+    dp->fillScreen(MY_DISPLAY_BGCOLOR); // transferred with the new page
+  }
+
+  // show next zoom level each time the graph page is entered
+  if ((DisplayPage == DISPLAY_PAGE_PAX_GRAPH) && (shown_page != DisplayPage))
+    graph_zoom = (graph_zoom + 1) % PAXGRAPH_ZOOMS;
+
+  // skip drawing and transfer to display if shown values are unchanged
+  libpax_counter_count(&count);
+  paxgraph_live(count.pax);
+  model_len = dp_model(DisplayPage, &count, model);
+  if ((DisplayPage == shown_page) && (model_len == shown_len) &&
+      !memcmp(model, shown, model_len * sizeof(uint32_t))) {
+    dp_stats.cpu_us += esp_timer_get_time() - start_us;
+    return;
+  }
+  memcpy(shown, model, model_len * sizeof(uint32_t));
+  shown_len = model_len;
+  shown_page = DisplayPage;
+  dp_stats.renders++;
+
+  dp->setCursor(0, 0);
 
   switch (DisplayPage) {
     // page 0: pax + parameters overview
@@ -197,7 +399,6 @@ void dp_refresh(bool nextPage) {
   case DISPLAY_PAGE_PAX_PARAM_OVERVIEW:
 
     // show pax
-    libpax_counter_count(&count);
     dp_setFont(MY_FONT_LARGE);
     dp->printf("%-8u", count.pax);
 
@@ -240,9 +441,10 @@ void dp_refresh(bool nextPage) {
 #if (TIME_SYNC_INTERVAL)
     timeState = TimePulseTick ? ' ' : timeSetSymbols[timeSource];
     time(&now);
-    localtime_r(&now, &timeinfo);
-    strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
-    dp->printf("%.20s", strftime_buf);
+    cal_localtime(now, &timeinfo);
+    dp->printf("%s %s %2d %02d:%02d:%02d ", cal_wday_names[timeinfo.tm_wday],
+               cal_month_names[timeinfo.tm_mon], timeinfo.tm_mday,
+               timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
 
 // display inverse timeState if clock controller is enabled
 #if (defined HAS_DCF77) || (defined HAS_IF482)
@@ -281,7 +483,6 @@ void dp_refresh(bool nextPage) {
     // 7|SNR:-0000  RSSI:-0000
 
     // show pax
-    libpax_counter_count(&count);
     dp_setFont(MY_FONT_LARGE);
     dp->printf("%-8u", count.pax);
 
@@ -308,31 +509,24 @@ void dp_refresh(bool nextPage) {
 #if (HAS_GPS)
 
     // show pax
-    libpax_counter_count(&count);
     dp_setFont(MY_FONT_LARGE);
     dp->printf("%-8u", count.pax);
 
     // show satellite status at bottom line
     dp_setFont(MY_FONT_SMALL);
     dp->setCursor(0, 56);
-    dp->printf("%u Sats", gps.satellites.value());
+    gps_getfix(&gpsfix);
+    dp->printf("%u Sats", gpsfix.satellites);
     dp->printf(gps_hasfix() ? "         " : " - No fix");
 
     // show latitude and longitude
     dp_setFont(MY_FONT_STRETCHED);
     dp->setCursor(0, MY_DISPLAY_FIRSTLINE);
-    if (gps.location.isUpdated()) {
-      // When reading the GPS location, the updated flag is reset.
-      // However if we also need to send the GPS location data, 
-      // we must know whether there has been an update since the last time
-      // we sent the location.
-      gps_location_isupdated = true;
-    }
-
-    dp->printf("%c%09.6f\r\n", gps.location.rawLat().negative ? 'S' : 'N',
-               gps.location.lat());
-    dp->printf("%c%09.6f", gps.location.rawLng().negative ? 'W' : 'E',
-               gps.location.lng());
+    dp->printf("%c%02u.%06u\r\n", gpsfix.latitude < 0 ? 'S' : 'N',
+               abs(gpsfix.latitude) / 1000000, abs(gpsfix.latitude) % 1000000);
+    dp->printf("%c%02u.%06u", gpsfix.longitude < 0 ? 'W' : 'E',
+               abs(gpsfix.longitude) / 1000000,
+               abs(gpsfix.longitude) % 1000000);
     dp_dump();
     break;
 #else // skip this page
@@ -362,15 +556,15 @@ void dp_refresh(bool nextPage) {
   case DISPLAY_PAGE_TIME_OF_DAY:
 
     time(&now);
-    localtime_r(&now, &timeinfo);
+    cal_localtime(now, &timeinfo);
 
     dp_setFont(MY_FONT_STRETCHED);
     dp->setCursor(0, 0);
     dp->printf("Timeofday:");
     dp->setCursor(0, 26);
     dp_setFont(MY_FONT_LARGE);
-    strftime(strftime_buf, sizeof(strftime_buf), "%T", &timeinfo);
-    dp->printf("%.8s\r\n", strftime_buf);
+    dp->printf("%02d:%02d:%02d\r\n", timeinfo.tm_hour, timeinfo.tm_min,
+               timeinfo.tm_sec);
     dp_setFont(MY_FONT_SMALL);
     dp->printf("%-12.1f", uptime() / 1000.0);
     dp_dump();
@@ -490,9 +684,9 @@ void dp_refresh(bool nextPage) {
   // ---------- page 6: pax graph ----------
   case DISPLAY_PAGE_PAX_GRAPH:
 
-    // update and show histogram
-    dp_plotCurve(count.pax, false);
-    dp_dump(plotbuf);
+    // show histogram
+    dp_plotCurve(graph_zoom);
+    dp_dump();
     break;
 
   // ---------- page 7: blank screen ----------
@@ -506,6 +700,8 @@ void dp_refresh(bool nextPage) {
     break;
 #endif
   } // switch (page)
+
+  dp_stats.cpu_us += esp_timer_get_time() - start_us;
 } // dp_refresh
 
 // ------------- display helper functions -----------------
@@ -519,17 +715,34 @@ void dp_setFont(int font, int inv) {
 }
 
 void dp_dump(uint8_t *pBuffer) {
-  if (pBuffer)
+  if (pBuffer) {
+    dp_wait();
     memcpy(dp->getBuffer(), pBuffer, PLOTBUFFERSIZE);
-  dp->display();
+  }
+  dp_flush();
 }
 
 void dp_clear(void) {
+  dp_wait();
   dp->fillScreen(MY_DISPLAY_BGCOLOR);
-  dp->display();
+  dp_flush();
   dp->setCursor(0, 0);
 }
 
+// log display load since last call
+void dp_logStats(void) {
+  static uint32_t last_ms = 0;
+  const uint32_t now = millis(), secs = (now - last_ms) / 1000;
+
+  if (secs)
+    ESP_LOGD(TAG,
+             "Display %u frames, %u redrawn | %u bytes/s | cpu %u us/s",
+             dp_stats.frames, dp_stats.renders, dp_stats.bytes / secs,
+             dp_stats.cpu_us / secs);
+  memset(&dp_stats, 0, sizeof(dp_stats));
+  last_ms = now;
+}
+
 void dp_contrast(uint8_t contrast) {
 #if (HAS_DISPLAY) == 1
   dp->setContrast(contrast);
@@ -539,6 +752,7 @@ void dp_contrast(uint8_t contrast) {
 }
 
 void dp_power(uint8_t screenon) {
+  pm_hold(PM_DISPLAY, screenon); // refresh timer stops in light sleep
 #if (HAS_DISPLAY) == 1
   dp->setPower(screenon);
 #elif (HAS_DISPLAY) > 1
@@ -581,98 +795,34 @@ void dp_printqr(uint16_t offset_x, uint16_t offset_y, const char *Message) {
                qrcode.size * QR_SCALEFACTOR + 2 * offset_y, MY_DISPLAY_FGCOLOR);
 }
 
-// ------------- graphics primitives -----------------
-
-int dp_drawPixel(uint8_t *buf, const uint16_t x, const uint16_t y,
-                 const uint8_t dot) {
-  if (x > MY_DISPLAY_WIDTH || y > MY_DISPLAY_HEIGHT)
-    return -1;
-
-  uint8_t bit = y & 7;
-  uint16_t idx = y / 8 * MY_DISPLAY_WIDTH + x;
-
-  buf[idx] &= ~(1 << bit); // clear pixel
-  if (dot)
-    buf[idx] |= (1 << bit); // set pixel
-
-  return 0;
-}
-
-// ------------- buffer scroll functions -----------------
-
-void dp_scrollHorizontal(uint8_t *buf, const uint16_t width,
-                         const uint16_t height, bool left) {
-  uint16_t col, page, idx = 0;
-
-  for (page = 0; page < height / 8; page++) {
-    if (left) { // scroll left
-      for (col = 0; col < width - 1; col++) {
-        idx = page * width + col;
-        buf[idx] = buf[idx + 1];
-      }
-      buf[idx + 1] = 0;
-    } else // scroll right
-    {
-      for (col = width - 1; col > 0; col--) {
-        idx = page * width + col;
-        buf[idx] = buf[idx - 1];
-      }
-      buf[idx - 1] = 0;
-    }
-  }
-}
-
-void dp_scrollVertical(uint8_t *buf, const uint16_t width,
-                       const uint16_t height, int offset) {
-  uint64_t buf_col;
+// ------------- curve plotter -----------------
 
-  if (!offset)
-    return; // nothing to do
+// draw pax graph of a zoom level from its ring buffer, scaled to fit
+void dp_plotCurve(uint8_t zoom) {
+  static const char *const zoom_names[PAXGRAPH_ZOOMS] = {"Cycle", "Hour",
+                                                         "Day"};
+  const uint16_t height = MY_DISPLAY_HEIGHT - MY_GRAPH_TOP;
+  uint16_t values[MY_DISPLAY_WIDTH];
+  uint16_t n = paxgraph_get(zoom, values, MY_DISPLAY_WIDTH);
+  uint16_t top = paxgraph_max(values, n);
 
-  for (uint16_t col = 0; col < MY_DISPLAY_WIDTH; col++) {
-    // convert column bytes from display buffer to uint64_t
-    buf_col = *(uint64_t *)&buf[col * MY_DISPLAY_HEIGHT / 8];
+  // scale only counts above graph height, smaller counts are plotted 1:1
+  uint16_t scale = max(top, (uint16_t)(height - 1));
 
-    if (offset > 0) // scroll down
-      buf_col <<= offset;
-    else // scroll up
-      buf_col >>= abs(offset);
+  dp->fillScreen(MY_DISPLAY_BGCOLOR);
+  dp_setFont(MY_FONT_SMALL);
+  dp->setCursor(0, 0);
+  dp->printf("%s max %u", zoom_names[zoom], top);
 
-    // write back uint64_t to uint8_t display buffer
-    *(uint64_t *)&buf[col * MY_DISPLAY_HEIGHT / 8] = buf_col;
+  int y, last_y = 0;
+  for (uint16_t x = 0; x < n; x++) {
+    y = MY_DISPLAY_HEIGHT - 1 - (uint32_t)values[x] * (height - 1) / scale;
+    if (x)
+      dp->drawLine(x - 1, last_y, x, y, MY_DISPLAY_FGCOLOR);
+    else
+      dp->drawPixel(x, y, MY_DISPLAY_FGCOLOR);
+    last_y = y;
   }
 }
 
-// ------------- curve plotter -----------------
-
-void dp_plotCurve(uint16_t count, bool reset) {
-  static uint16_t last_count = 0, col = 0, row = 0;
-  uint16_t v_scroll = 0;
-
-  // nothing new to plot? -> then exit early
-  if ((last_count == count) && !reset)
-    return;
-
-  if (reset) {                      // next count cycle?
-    if (col < MY_DISPLAY_WIDTH - 1) // matrix not full -> increment column
-      col++;
-    else // matrix full -> scroll left 1 dot
-      dp_scrollHorizontal(plotbuf, MY_DISPLAY_WIDTH, MY_DISPLAY_HEIGHT, true);
-
-  } else // clear current dot
-    dp_drawPixel(plotbuf, col, row, 0);
-
-  // scroll down, if necessary
-  while ((count - v_scroll) > MY_DISPLAY_HEIGHT - 1)
-    v_scroll++;
-  if (v_scroll)
-    dp_scrollVertical(plotbuf, MY_DISPLAY_WIDTH, MY_DISPLAY_HEIGHT, v_scroll);
-
-  // set new dot
-  // row = MY_DISPLAY_HEIGHT - 1 - (count - v_scroll) % MY_DISPLAY_HEIGHT;
-  row = MY_DISPLAY_HEIGHT - 1 - count - v_scroll;
-  last_count = count;
-  dp_drawPixel(plotbuf, col, row, 1);
-}
-
 #endif // HAS_DISPLAY
@@ -2,13 +2,17 @@
 
 #include "globals.h"
 #include "gpsread.h"
+#include "timefusion.h"
 
-
-TinyGPSPlus gps;
-bool gps_location_isupdated = false;
 TaskHandle_t GpsTask;
 HardwareSerial GPS_Serial(1); // use UART #1
 
+// decoded GPS data, written by gps_loop, read by others via gps_getfix()
+static nmeaFix_t gps_fix = {0};
+static nmeaDecoder_t gps_decoder = {0};
+static portMUX_TYPE gpsMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t gps_stored_ms = 0; // location_ms of last stored location
+
 // Ublox UBX packet data
 
 // UBX CFG-PRT packet
@@ -83,6 +87,24 @@ byte CFG_CFG[] = {
     0b00010001  // devicemask
 };
 
+// UBX RXM-PMREQ packet
+byte RXM_PMREQ[] = {
+    0xB5,       // sync char 1
+    0x62,       // sync char 2
+    0x02,       // class
+    0x41,       // id
+    0x08,       // length
+    0x00,       // .
+    0x00,       // duration [ms], 0 = infinite
+    0x00,       // .
+    0x00,       // .
+    0x00,       // .
+    0b00000010, // flags: backup
+    0x00,       // .
+    0x00,       // .
+    0x00        // .
+};
+
 // helper functions to send UBX commands to ublox gps chip
 
 void sendPacket(byte *packet, byte len) {
@@ -105,7 +127,7 @@ void restoreDefaults() { sendPacket(CFG_CFG, sizeof(CFG_CFG)); }
 void changeBaudrate() { sendPacket(CFG_PRT, sizeof(CFG_PRT)); }
 
 void disableNmea() {
-  // tinygps++ processes only $GPGGA/$GNGGA and $GPRMC/$GNRMC
+  // our NMEA decoder processes only $GPGGA/$GNGGA and $GPRMC/$GNRMC
   // thus, we disable all other NMEA messages
 
   byte packetSize = sizeof(CFG_MSG);
@@ -142,30 +164,85 @@ int gps_init(void) {
   return 1;
 } // gps_init()
 
+// get a consistent copy of the decoded GPS data
+void gps_getfix(nmeaFix_t *fix) {
+  taskENTER_CRITICAL(&gpsMux);
+  *fix = gps_fix;
+  taskEXIT_CRITICAL(&gpsMux);
+}
+
+// age of a GPS value [ms], given its update timestamp
+uint32_t gps_age(uint32_t stamp) {
+  return stamp ? millis() - stamp : UINT32_MAX;
+}
+
 // store current GPS location data in struct
 bool gps_storelocation(gpsStatus_t *gps_store) {
-  if (gps.location.isUpdated() || gps_location_isupdated) {
-    gps_location_isupdated = false;
-    if (gps.location.isValid() &&
-        (gps.location.age() < 1500)) {
-      gps_store->latitude = (int32_t)(gps.location.lat() * 1e6);
-      gps_store->longitude = (int32_t)(gps.location.lng() * 1e6);
-      gps_store->satellites = (uint8_t)gps.satellites.value();
-      gps_store->hdop = (uint16_t)gps.hdop.value();
-      gps_store->altitude = (int16_t)gps.altitude.meters();
+  nmeaFix_t fix;
+  gps_getfix(&fix);
+  if (fix.location_ms != gps_stored_ms) {
+    gps_stored_ms = fix.location_ms;
+    if (gps_age(fix.location_ms) < 1500) {
+      gps_store->latitude = fix.latitude;
+      gps_store->longitude = fix.longitude;
+      gps_store->satellites = fix.satellites;
+      gps_store->hdop = fix.hdop;
+      gps_store->altitude = (int16_t)(fix.altitude / 100);
       return true;
     }
   }
   return false;
 }
 
+// movement gate, true if position shall be sent
+bool gps_moved(const gpsStatus_t *gps_store) {
+#if (GPS_MOVE_DISTANCE > 0)
+  static gpsStatus_t last = {0};
+  static uint32_t last_ms = 0;
+
+  if (last_ms) {
+    // equirectangular approximation, sufficient for short distances
+    const float m_per_udeg = 0.111195f; // earth radius * pi / 180 / 1e6
+    float dy = (gps_store->latitude - last.latitude) * m_per_udeg;
+    float dx = (gps_store->longitude - last.longitude) * m_per_udeg *
+               cosf((float)gps_store->latitude * (float)(PI / 180e6));
+    bool moved = (dx * dx + dy * dy) >
+                 (float)GPS_MOVE_DISTANCE * (float)GPS_MOVE_DISTANCE;
+    bool expired = (GPS_MOVE_INTERVAL > 0) &&
+                   (millis() - last_ms >= GPS_MOVE_INTERVAL * 3600000UL);
+    if (!moved && !expired) {
+      ESP_LOGD(TAG, "GPS position unchanged, not sent");
+      return false;
+    }
+  }
+  last = *gps_store;
+  last_ms = millis() | 1; // 0 means no position sent yet
+#endif
+  return true;
+}
+
+// put GPS in backup mode until shortly before next position is needed
+void gps_standby(uint32_t next_ms) {
+#if (GPS_BACKUP)
+  if (next_ms <= 2 * GPS_BACKUP_LEAD * 1000UL)
+    return; // not worth it, GPS needs lead time to regain fix
+  uint32_t duration = next_ms - GPS_BACKUP_LEAD * 1000UL;
+  RXM_PMREQ[6] = (byte)duration;
+  RXM_PMREQ[7] = (byte)(duration >> 8);
+  RXM_PMREQ[8] = (byte)(duration >> 16);
+  RXM_PMREQ[9] = (byte)(duration >> 24);
+  sendPacket(RXM_PMREQ, sizeof(RXM_PMREQ));
+  ESP_LOGD(TAG, "GPS backup mode for %u sec", duration / 1000);
+#endif
+}
+
 bool gps_hasfix() {
   // adapted from source:
   // https://github.com/hottimuc/Lora-TTNMapper-T-Beam/blob/master/fromV08/gps.cpp
-  return (gps.location.isValid() && gps.location.age() < 4000 &&
-          gps.hdop.isValid() && gps.hdop.value() <= 600 &&
-          gps.hdop.age() < 4000 && gps.altitude.isValid() &&
-          gps.altitude.age() < 4000);
+  nmeaFix_t fix;
+  gps_getfix(&fix);
+  return (gps_age(fix.location_ms) < 4000 && gps_age(fix.hdop_ms) < 4000 &&
+          fix.hdop <= 600 && gps_age(fix.altitude_ms) < 4000);
 }
 
 // function to poll UTC time from GPS NMEA data; note: this is costly
@@ -173,16 +250,19 @@ time_t get_gpstime(uint16_t *msec = 0) {
   const uint16_t txDelay =
       70U * 1000 / (GPS_BAUDRATE / 9); // serial tx of 70 NMEA chars
 
+  nmeaFix_t fix;
+  gps_getfix(&fix);
+
   // did we get a current date & time?
-  if (gps.time.age() < 1000) {
-    // convert tinygps time format to struct tm format
+  if (gps_age(fix.time_ms) < 1000 && fix.date_ms) {
+    // convert NMEA time format to struct tm format
     struct tm gps_tm = {0};
-    gps_tm.tm_sec = gps.time.second();
-    gps_tm.tm_min = gps.time.minute();
-    gps_tm.tm_hour = gps.time.hour();
-    gps_tm.tm_mday = gps.date.day();
-    gps_tm.tm_mon = gps.date.month() - 1;    // 1-12 -> 0-11
-    gps_tm.tm_year = gps.date.year() - 1900; // 2000+ -> years since 1900
+    gps_tm.tm_sec = fix.second;
+    gps_tm.tm_min = fix.minute;
+    gps_tm.tm_hour = fix.hour;
+    gps_tm.tm_mday = fix.day;
+    gps_tm.tm_mon = fix.month - 1;    // 1-12 -> 0-11
+    gps_tm.tm_year = fix.year - 1900; // 2000+ -> years since 1900
 
     // convert UTC tm to time_t epoch
     gps_tm.tm_isdst = 0; // UTC has no DST
@@ -199,7 +279,7 @@ time_t get_gpstime(uint16_t *msec = 0) {
     }
 #else
     // best guess for sync on top of next second
-    *msec = gps.time.centisecond() * 10U + txDelay;
+    *msec = fix.centisecond * 10U + txDelay;
 #endif
 
     return t;
@@ -209,19 +289,50 @@ time_t get_gpstime(uint16_t *msec = 0) {
   return 0;
 } // get_gpstime()
 
+// error bound of GPS time [ms], poor satellite geometry degrades it
+uint32_t get_gpserror(void) {
+#ifdef GPS_INT
+  uint32_t error = TIME_ERROR_GPS_PPS;
+#else
+  uint32_t error = TIME_ERROR_GPS;
+#endif
+  nmeaFix_t fix;
+  gps_getfix(&fix);
+  // hdop is in 1/100, scale error up above hdop 2
+  if (fix.hdop_ms && (fix.hdop > 200))
+    error = error * fix.hdop / 200;
+  return error;
+} // get_gpserror()
+
+// called by the UART driver's event task when data was received
+static void gps_onreceive(void) { xTaskNotifyGive(GpsTask); }
+
 // GPS serial feed FreeRTos Task
 void gps_loop(void *pvParameters) {
   _ASSERT((uint32_t)pvParameters == 1); // FreeRTOS check
 
+  char buf[128];
+  size_t len;
+  nmeaFix_t fix;
+
+  // wake up on received data instead of polling the serial port
+  GPS_Serial.onReceive(gps_onreceive);
+
   // feed GPS decoder with serial NMEA data from GPS device
   while (1) {
-    while (cfg.payloadmask & GPS_DATA) {
-      while (GPS_Serial.available())
-        gps.encode(GPS_Serial.read());
-
-      delay(5);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+
+    while ((len = GPS_Serial.available()) > 0) {
+      len = GPS_Serial.read((uint8_t *)buf, min(len, sizeof(buf)));
+      if (!(cfg.payloadmask & GPS_DATA))
+        continue; // drain serial buffer, but don't decode
+      // decode on a private copy, then publish it in one go
+      gps_getfix(&fix);
+      nmea_feed(&gps_decoder, &fix, buf, len, millis());
+      taskENTER_CRITICAL(&gpsMux);
+      gps_fix = fix;
+      taskEXIT_CRITICAL(&gpsMux);
     }
-    delay(1000);
   } // infinite while loop
 } // gps_loop()
 
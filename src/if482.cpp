@@ -81,21 +81,59 @@ not evaluated by model BU-190, use "F" instead for this model
 
 #include "if482.h"
 
+/* The telegram of the next second is built ahead by the clock task, into one
+of two buffers. The 10ms clock tick interrupt writes it directly into the
+UART FIFO at the tick where its transmission ends at top of second. */
+
+HardwareSerial IF482(2); // use UART #2 (#1 may be in use for serial GPS)
+#if (HAS_SDS011)
+#error cannot use IF482 together with SDS011 (both use UART#2)
+#endif
+
+static DRAM_ATTR char if482_frame[2][IF482_FRAME_SIZE + 1];
+static DRAM_ATTR uint32_t if482_second[2]; // second each telegram is for
+static DRAM_ATTR uint8_t if482_txtick;     // tick to start transmission
+
+void IF482_Init(void) {
+  IF482.begin(HAS_IF482);
+  if482_txtick = (1000 - IF482_SYNC_FIXUP -
+                  tx_Ticks(IF482_FRAME_SIZE, HAS_IF482)) /
+                 10;
+}
+
+// build telegram for second following second t
+void IF482_Schedule(time_t t) {
+  uint32_t next = t + 1;
+  // buffer is not in use by interrupt, which may still send second t
+  strncpy(if482_frame[next & 1], IF482_Frame(next).c_str(),
+          IF482_FRAME_SIZE + 1);
+  if482_second[next & 1] = next;
+  ESP_LOGD(TAG, "[%0.3f] IF482: %s", _seconds(), if482_frame[next & 1]);
+}
+
+// clock tick since top of second t, called by 10ms timer interrupt
+void IRAM_ATTR IF482_Tick(uint8_t tick, time_t t) {
+  uint32_t next = t + 1;
+  if ((tick == if482_txtick) && (if482_second[next & 1] == next))
+    uart_ll_write_txfifo(&UART2, (const uint8_t *)if482_frame[next & 1],
+                         IF482_FRAME_SIZE);
+}
+
 
 String IF482_Frame(time_t t) {
-  char mon, out[IF482_FRAME_SIZE + 1], buf[IF482_FRAME_SIZE - 3];
+  char mon, out[IF482_FRAME_SIZE + 1];
 
   if (sntp_get_sync_status() == SNTP_SYNC_STATUS_IN_PROGRESS)
     mon = 'M'; // time had been set but sync not completed
   else
     mon = 'A'; // time has been set and was recently synced
 
-  // generate IF482 telegram for local time
+  // generate IF482 telegram for local time, weekday 1..7 is monday..sunday
   struct tm tt;
-  localtime_r(&t, &tt);
-  mktime(&tt);
-  strftime(buf, sizeof(buf), "%y%m%d%u%H%M%S", &tt);
-  snprintf(out, sizeof(out), "O%cL%s\r", mon, buf);
+  cal_localtime(t, &tt);
+  snprintf(out, sizeof(out), "O%cL%02d%02d%02d%d%02d%02d%02d\r", mon,
+           tt.tm_year % 100, tt.tm_mon + 1, tt.tm_mday,
+           tt.tm_wday ? tt.tm_wday : 7, tt.tm_hour, tt.tm_min, tt.tm_sec);
 
   return out;
 }
@@ -3,85 +3,172 @@
 
 TaskHandle_t irqHandlerTask = NULL;
 
-// irq handler task, handles all our application level interrupts
-void irqHandler(void *pvParameters) {
-  _ASSERT((uint32_t)pvParameters == 1); // FreeRTOS check
+/* application irq dispatcher
 
-  uint32_t irqSource;
+Irqs are notification bits, thus repeated irqs coalesce until handled. The
+table below lists the handlers in order of priority. Of all pending irqs
+the one with the highest priority is dispatched, unless an irq exceeded
+its deadline, then the most overdue one goes first. New notifications are
+collected after each handler, so a more urgent irq overtakes the rest of
+the queue.
 
-  // task remains in blocked state until it is notified by an irq
-  for (;;) {
-    xTaskNotifyWait(0x00,           // Don't clear any bits on entry
-                    ULONG_MAX,      // Clear all bits on exit
-                    &irqSource,     // Receives the notification value
-                    portMAX_DELAY); // wait forever
-
-    if (irqSource & UNMASK_IRQ) // interrupt handler to be enabled?
-      irqSource &= ~MASK_IRQ;   // then clear irq mask flag
-    // else suppress processing if interrupt handler is disabled
-    // or time critical lmic jobs are pending in next 100ms
-    else if ((irqSource & MASK_IRQ)
-#if (HAS_LORA)
-             || os_queryTimeCriticalJobs(ms2osticks(100))
-#endif
-    )
-      continue;
+While irqs are masked, or time critical lmic jobs are due, pending irqs are
+deferred, not discarded. Masking nests: irqs stay masked until each
+mask_user_IRQ() was matched by an unmask_user_IRQ(). The mask count is kept
+outside the notification bits, which would lose the order of a mask and an
+unmask notified in one batch.
+*/
 
-// button pressed?
-#ifdef HAS_BUTTON
-    if (irqSource & BUTTON_IRQ)
-      readButton();
-#endif
+static portMUX_TYPE irq_mask_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint8_t irq_masked = 0; // nesting depth of mask_user_IRQ()
+
+// handler wrappers
 
-// display needs refresh?
 #ifdef HAS_DISPLAY
-    if (irqSource & DISPLAY_IRQ)
-      dp_refresh();
+static void irq_display(void) { dp_refresh(); }
 #endif
 
-// LED Matrix display needs refresh?
 #ifdef HAS_MATRIX_DISPLAY
-    if (irqSource & MATRIX_DISPLAY_IRQ)
-      refreshTheMatrixDisplay();
-#endif
-
-#if (TIME_SYNC_INTERVAL)
-    // is time to be synced?
-    if (irqSource & TIMESYNC_IRQ) {
-      calibrateTime();
-    }
+static void irq_matrix(void) { refreshTheMatrixDisplay(); }
 #endif
 
-// BME sensor data to be read?
 #if (HAS_BME)
-    if (irqSource & BME_IRQ)
-      bme_storedata(&bme_status);
+static void irq_bme(void) { bme_storedata(&bme_status); }
 #endif
 
-    // are cyclic tasks due?
-    if (irqSource & CYCLIC_IRQ)
-      doHousekeeping();
+static void irq_sendcycle(void) {
+  sendData();
+  // goto sleep if we have a sleep cycle
+  if (cfg.sleepcycle)
+#ifdef HAS_BUTTON
+    enter_deepsleep(cfg.sleepcycle * 10UL, (gpio_num_t)HAS_BUTTON);
+#else
+    enter_deepsleep(cfg.sleepcycle * 10UL, GPIO_NUM_MAX);
+#endif
+}
 
-// do we have a power event?
+// irq, handler, deadline [ms], name; ordered by priority
+static const irqEvent_t irqEvents[] = {
+    {SENDCYCLE_IRQ, irq_sendcycle, 1000, "send"},
 #ifdef HAS_PMU
-    if (irqSource & PMU_IRQ)
-      PMU_powerevent_IRQ();
+    {PMU_IRQ, PMU_powerevent_IRQ, 100, "pmu"},
+#endif
+#if (TIME_SYNC_INTERVAL)
+    {TIMESYNC_IRQ, calibrateTime, 1000, "timesync"},
 #endif
-
-    // is time to send the payload?
-    if (irqSource & SENDCYCLE_IRQ) {
-      sendData();
-      // goto sleep if we have a sleep cycle
-      if (cfg.sleepcycle)
 #ifdef HAS_BUTTON
-        enter_deepsleep(cfg.sleepcycle * 10UL, (gpio_num_t)HAS_BUTTON);
-#else
-        enter_deepsleep(cfg.sleepcycle * 10UL, GPIO_NUM_MAX);
+    {BUTTON_IRQ, readButton, 100, "button"},
+#endif
+#if (HAS_BME)
+    {BME_IRQ, irq_bme, 1000, "bme"},
+#endif
+#ifdef HAS_DISPLAY
+    {DISPLAY_IRQ, irq_display, 2 * DISPLAYREFRESH_MS, "display"},
+#endif
+#ifdef HAS_MATRIX_DISPLAY
+    {MATRIX_DISPLAY_IRQ, irq_matrix, 2 * MATRIX_DISPLAY_REFRESH_MS, "matrix"},
+#endif
+#if (HAS_LORA) && (LORA_SESSION_PERSIST) && !defined(LORA_ABP)
+    {LORA_SESSION_IRQ, lora_session_store, 5000, "session"},
+#endif
+    {CYCLIC_IRQ, doHousekeeping, 5000, "housekeeping"},
+};
+
+#define IRQ_EVENTS (sizeof(irqEvents) / sizeof(irqEvents[0]))
+
+static irqStats_t irqStats[IRQ_EVENTS] = {0};
+static uint32_t irqSince[IRQ_EVENTS]; // time irq became pending [ms]
+
+// index of next irq to dispatch
+static uint8_t irq_next(uint32_t pending, uint32_t now) {
+  uint8_t next = IRQ_EVENTS;
+  int32_t overdue, most = 0;
+
+  for (uint8_t i = 0; i < IRQ_EVENTS; i++) {
+    if (!(pending & irqEvents[i].irq))
+      continue;
+    if (next == IRQ_EVENTS)
+      next = i; // highest priority
+    overdue = (int32_t)(now - irqSince[i]) - (int32_t)irqEvents[i].deadline;
+    if (overdue > most) {
+      most = overdue;
+      next = i;
+    }
+  }
+  return next;
+}
+
+// irq handler task, handles all our application level interrupts
+void irqHandler(void *pvParameters) {
+  _ASSERT((uint32_t)pvParameters == 1); // FreeRTOS check
+
+  uint32_t irqSource, pending = 0, now, latency;
+  TickType_t wait = portMAX_DELAY;
+  uint8_t i;
+
+  // task remains in blocked state until it is notified by an irq
+  for (;;) {
+    if (xTaskNotifyWait(0x00,       // Don't clear any bits on entry
+                        ULONG_MAX,  // Clear all bits on exit
+                        &irqSource, // Receives the notification value
+                        wait) == pdTRUE) {
+      // note time when irq became pending
+      now = millis();
+      for (i = 0; i < IRQ_EVENTS; i++)
+        if ((irqSource & irqEvents[i].irq) && !(pending & irqEvents[i].irq))
+          irqSince[i] = now;
+      pending |= irqSource & ~UNMASK_IRQ;
+    }
+
+    // nothing to do, or masked? then wait for next notification
+    wait = portMAX_DELAY;
+    if (!pending || irq_masked)
+      continue; // unmask_user_IRQ() wakes us up
+
+#if (HAS_LORA)
+    // defer processing if time critical lmic jobs are pending in next 100ms
+    if (os_queryTimeCriticalJobs(ms2osticks(100))) {
+      wait = pdMS_TO_TICKS(IRQ_DEFER_MS);
+      continue;
+    }
 #endif
+
+    now = millis();
+    i = irq_next(pending, now);
+    if (i == IRQ_EVENTS) { // irq without handler
+      pending = 0;
+      continue;
     }
+    pending &= ~irqEvents[i].irq;
+
+    // dispatch latency statistics
+    latency = now - irqSince[i];
+    irqStats[i].count++;
+    irqStats[i].sum_ms += latency;
+    irqStats[i].max_ms = max(irqStats[i].max_ms, latency);
+    if (latency > irqEvents[i].deadline)
+      irqStats[i].misses++;
+
+    irqEvents[i].handler();
+
+    // poll for new irqs before dispatching next pending irq
+    wait = 0;
   } // for
 } // irqHandler()
 
+// log dispatch latency statistics since last call
+void irq_logStats(void) {
+  for (uint8_t i = 0; i < IRQ_EVENTS; i++) {
+    if (irqStats[i].count)
+      ESP_LOGD(TAG,
+               "IRQ %s: %u dispatched | latency avg %u max %u ms | %u late",
+               irqEvents[i].name, irqStats[i].count,
+               irqStats[i].sum_ms / irqStats[i].count, irqStats[i].max_ms,
+               irqStats[i].misses);
+  }
+  memset(irqStats, 0, sizeof(irqStats));
+}
+
 // timer triggered interrupt service routines
 // they notify the irq handler task
 
@@ -102,16 +189,19 @@ void IRAM_ATTR DisplayIRQ() {
 }
 #endif
 
-#ifdef HAS_MATRIX_DISPLAY
-void IRAM_ATTR MatrixDisplayIRQ() {
-  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-  xTaskNotifyFromISR(irqHandlerTask, MATRIX_DISPLAY_IRQ, eSetBits,
-                     &xHigherPriorityTaskWoken);
-  if (xHigherPriorityTaskWoken)
-    portYIELD_FROM_ISR();
+void mask_user_IRQ() {
+  portENTER_CRITICAL(&irq_mask_mux);
+  if (irq_masked < UINT8_MAX)
+    irq_masked++;
+  portEXIT_CRITICAL(&irq_mask_mux);
 }
-#endif
-
-void mask_user_IRQ() { xTaskNotify(irqHandlerTask, MASK_IRQ, eSetBits); }
 
-void unmask_user_IRQ() { xTaskNotify(irqHandlerTask, UNMASK_IRQ, eSetBits); }
\ No newline at end of file
+void unmask_user_IRQ() {
+  portENTER_CRITICAL(&irq_mask_mux);
+  if (irq_masked)
+    irq_masked--;
+  portEXIT_CRITICAL(&irq_mask_mux);
+  // wake irq handler to dispatch irqs deferred while masked
+  if (irqHandlerTask != NULL)
+    xTaskNotify(irqHandlerTask, UNMASK_IRQ, eSetBits);
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+// Basic Config
+#include "globals.h"
+#include "jobtimer.h"
+
+/* job timer
+
+All periodic and one shot software timers share one esp_timer. Each job
+has a slack window after its due time, in which it may be run. The timer is
+armed for the earliest end of a slack window, and on each wakeup all jobs
+already due are run together, so jobs due close to each other cause one
+wakeup only. Due times are aligned to a coarse (1 sec) or fine (10 ms)
+grid, thus jobs with similar periods fall on the same instant.
+
+Callbacks are run in the esp_timer task, as with Ticker, thus they must be
+short, e.g. notify a task.
+*/
+
+static JobTimer *jobs = NULL; // active jobs
+static esp_timer_handle_t jobTimer = NULL;
+static uint32_t jobWakeups = 0;
+
+static SemaphoreHandle_t job_lock(void) {
+  static StaticSemaphore_t buffer;
+  static SemaphoreHandle_t mutex = xSemaphoreCreateMutexStatic(&buffer);
+  return mutex;
+}
+
+// arm esp_timer for end of earliest slack window, call with lock held
+static void job_arm(uint64_t now) {
+  uint64_t wake = UINT64_MAX;
+
+  for (JobTimer *j = jobs; j; j = j->next())
+    wake = min(wake, j->deadline());
+
+  if (jobTimer == NULL) {
+    const esp_timer_create_args_t args = {.callback = &JobTimer::service,
+                                          .arg = NULL,
+                                          .dispatch_method = ESP_TIMER_TASK,
+                                          .name = "jobtimer",
+                                          .skip_unhandled_events = false};
+    esp_timer_create(&args, &jobTimer);
+  }
+  esp_timer_stop(jobTimer);
+  if (wake != UINT64_MAX)
+    esp_timer_start_once(jobTimer, wake > now ? wake - now : 1);
+}
+
+// align due time to grid, rounding up
+static uint64_t job_align(uint64_t t, uint64_t period) {
+  const uint64_t grid = (period >= JOBTIMER_COARSE_MS * 1000ULL)
+                            ? JOBTIMER_COARSE_MS * 1000ULL
+                            : JOBTIMER_FINE_MS * 1000ULL;
+  return (t + grid - 1) / grid * grid;
+}
+
+JobTimer::JobTimer()
+    : _callback(NULL), _due(0), _period(0), _slack(0), _repeat(false),
+      _next(NULL) {}
+
+JobTimer::~JobTimer() { detach(); }
+
+void JobTimer::attach(float seconds, callback_t callback, uint32_t slack_ms) {
+  start(seconds * 1000000ULL, true, callback, slack_ms);
+}
+
+void JobTimer::attach_ms(uint32_t milliseconds, callback_t callback,
+                         uint32_t slack_ms) {
+  start(milliseconds * 1000ULL, true, callback, slack_ms);
+}
+
+void JobTimer::once(float seconds, callback_t callback, uint32_t slack_ms) {
+  start(seconds * 1000000ULL, false, callback, slack_ms);
+}
+
+void JobTimer::once_ms(uint32_t milliseconds, callback_t callback,
+                       uint32_t slack_ms) {
+  start(milliseconds * 1000ULL, false, callback, slack_ms);
+}
+
+void JobTimer::start(uint64_t period_us, bool repeat, callback_t callback,
+                     uint32_t slack_ms) {
+  if (slack_ms == JOBTIMER_SLACK_AUTO)
+    slack_ms = min((uint32_t)(period_us / 8000), (uint32_t)JOBTIMER_SLACK_MAX);
+
+  xSemaphoreTake(job_lock(), portMAX_DELAY);
+  unlink();
+  const uint64_t now = esp_timer_get_time();
+  _callback = callback;
+  _period = max(period_us, (uint64_t)(JOBTIMER_FINE_MS * 1000UL));
+  _repeat = repeat;
+  _slack = slack_ms * 1000UL;
+  _due = job_align(now + _period, _period);
+  _next = jobs;
+  jobs = this;
+  job_arm(now); // new job may be due before current wakeup
+  xSemaphoreGive(job_lock());
+}
+
+void JobTimer::detach() {
+  xSemaphoreTake(job_lock(), portMAX_DELAY);
+  unlink();
+  xSemaphoreGive(job_lock());
+}
+
+bool JobTimer::active() {
+  bool found = false;
+  xSemaphoreTake(job_lock(), portMAX_DELAY);
+  for (JobTimer *j = jobs; j; j = j->_next)
+    if (j == this)
+      found = true;
+  xSemaphoreGive(job_lock());
+  return found;
+}
+
+// remove from list of active jobs, call with lock held
+void JobTimer::unlink() {
+  for (JobTimer **p = &jobs; *p; p = &(*p)->_next)
+    if (*p == this) {
+      *p = _next;
+      _next = NULL;
+      return;
+    }
+}
+
+// esp_timer callback, runs all due jobs
+void JobTimer::service(void *arg) {
+  callback_t due[JOBTIMER_BATCH];
+  uint8_t n = 0;
+
+  xSemaphoreTake(job_lock(), portMAX_DELAY);
+  const uint64_t now = esp_timer_get_time();
+  jobWakeups++;
+
+  for (JobTimer **p = &jobs; *p;) {
+    JobTimer *j = *p;
+    if ((j->_due <= now) && (n < JOBTIMER_BATCH)) {
+      due[n++] = j->_callback;
+      if (!j->_repeat) { // one shot job is done
+        *p = j->_next;
+        j->_next = NULL;
+        continue;
+      }
+      // next due time on the job's grid, skipping missed periods
+      j->_due += ((now - j->_due) / j->_period + 1) * j->_period;
+    }
+    p = &j->_next;
+  }
+
+  job_arm(now);
+  xSemaphoreGive(job_lock());
+
+  // run callbacks without lock, they may attach or detach jobs
+  for (uint8_t i = 0; i < n; i++)
+    due[i]();
+}
+
+// number of timer wakeups
+uint32_t JobTimer::wakeups(bool reset) {
+  uint32_t w = jobWakeups;
+  if (reset)
+    jobWakeups = 0;
+  return w;
+}
@@ -72,15 +72,38 @@ void switch_LED1(led_states state) {
 }
 
 
+// LED state may have changed, e.g. by a LoRaWAN event
+void led_wake(void) {
 #if (HAS_LED != NOT_A_PIN) || defined(HAS_RGB_LED)
+  if (ledLoopTask != NULL)
+    xTaskNotifyGive(ledLoopTask);
+#endif
+}
+
+#if (HAS_LED != NOT_A_PIN) || defined(HAS_RGB_LED)
+
+// set LED state by a blink pattern, returns ms until the pattern changes it
+static uint32_t led_pattern(uint32_t period, uint32_t on) {
+  uint32_t phase = millis() % period;
+  LEDState = (phase < on) ? LED_ON : LED_OFF;
+  return (phase < on) ? on - phase : period - phase;
+}
 
 void ledLoop(void *parameter) {
   while (1) {
+    // wait for next LED change or a notification by led_wake(), nothing to
+    // wait for if LED stays off
+#if (HAS_LORA)
+    uint32_t wait = LED_IDLE_MS;
+#else
+    uint32_t wait = portMAX_DELAY;
+#endif
     // Custom blink running always have priority other LoRaWAN led
     // management
     if (LEDBlinkStarted && LEDBlinkDuration) {
       // Custom blink is finished, let this order, avoid millis() overflow
-      if ((long)(millis() - LEDBlinkStarted) >= LEDBlinkDuration) {
+      uint32_t elapsed = millis() - LEDBlinkStarted;
+      if (elapsed >= LEDBlinkDuration) {
         // Led becomes off, and stop blink
         LEDState = LED_OFF;
         LEDBlinkStarted = 0;
@@ -89,6 +112,7 @@ void ledLoop(void *parameter) {
       } else {
         // In case of LoRaWAN led management blinked off
         LEDState = LED_ON;
+        wait = LEDBlinkDuration - elapsed;
       }
       // No custom blink, check LoRaWAN state
     } else {
@@ -97,8 +121,7 @@ void ledLoop(void *parameter) {
       if (LMIC.opmode & (OP_JOINING | OP_REJOIN)) {
         LEDColor = COLOR_YELLOW;
         // quick blink 20ms on each 1/5 second
-        LEDState =
-            ((millis() % 200) < 20) ? LED_ON : LED_OFF; // TX data pending
+        wait = led_pattern(200, 20); // TX data pending
       } else if (LMIC.opmode & (OP_TXDATA | OP_TXRXPEND)) {
         // select color to blink by message port
         switch (LMIC.pendTxPort) {
@@ -113,13 +136,13 @@ void ledLoop(void *parameter) {
           break;
         }
         // small blink 10ms on each 1/2sec (not when joining)
-        LEDState = ((millis() % 500) < 10) ? LED_ON : LED_OFF;
+        wait = led_pattern(500, 10);
         // This should not happen so indicate a problem
       } else if (LMIC.opmode &
                  ((OP_TXDATA | OP_TXRXPEND | OP_JOINING | OP_REJOIN) == 0)) {
         LEDColor = COLOR_RED;
         // heartbeat long blink 200ms on each 2 seconds
-        LEDState = ((millis() % 2000) < 200) ? LED_ON : LED_OFF;
+        wait = led_pattern(2000, 200);
       } else
 #endif // HAS_LORA
       {
@@ -144,8 +167,9 @@ void ledLoop(void *parameter) {
       }
       previousLEDState = LEDState;
     }
-    // give yield to CPU
-    delay(5);
+    // sleep until then, instead of polling
+    ulTaskNotifyTake(pdTRUE, wait == portMAX_DELAY ? portMAX_DELAY
+                                                   : pdMS_TO_TICKS(wait) + 1);
   } // while(1)
 };  // ledloop()
 
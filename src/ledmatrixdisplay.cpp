@@ -2,14 +2,22 @@
 
 #include "globals.h"
 #include "ledmatrixdisplay.h"
+#include "irqhandler.h"
 
 #define MATRIX_DISPLAY_PAGES (2) // number of display pages
-#define LINE_DIAGRAM_DIVIDER (2) // scales pax numbers to led rows
+#define LINE_DIAGRAM_DIVIDER (2) // min. pax numbers per led row
 
 
 uint8_t MatrixDisplayIsOn = 0;
 static uint8_t displaybuf[LED_MATRIX_WIDTH * LED_MATRIX_HEIGHT / 8] = {0};
+
+// buffer clocked out by timer interrupt, updated only if displaybuf changed
+static uint8_t scanbuf[LED_MATRIX_WIDTH * LED_MATRIX_HEIGHT / 8] = {0};
+static volatile bool scan_on = false;
+static volatile uint8_t scan_mask = 0xff; // LEDs are lit on low level
+JobTimer matrixDisplayTimer;
 static unsigned long ulLastNumMacs = 0;
+static uint32_t ulLastGraph = 0; // pax graph revision shown
 static time_t ulLastTime = time(NULL);
 static struct count_payload_t count; // libpax count storage
 
@@ -28,24 +36,94 @@ const FONT_INFO *ActiveFontInfo = &digital7_18ptFontInfo;
 const uint8_t *iaActiveFont = ActiveFontInfo->Bitmap;
 const FONT_CHAR_INFO *ActiveFontCharInfo = ActiveFontInfo->Descriptors;
 
+// glyphs of active font, pre-shifted for all 8 bit offsets within a byte,
+// so drawing a char is ORing 3 bytes per row into displaybuf
+static uint8_t GlyphCache[MATRIX_GLYPHS][8][LED_MATRIX_HEIGHT][3];
+static uint8_t GlyphHeight[MATRIX_GLYPHS];
+static uint8_t GlyphCount = 0;
+
+static void BuildGlyphCache(void) {
+  GlyphCount = min(ActiveFontInfo->EndChar - ActiveFontInfo->StartChar + 1,
+                   MATRIX_GLYPHS);
+
+  for (uint8_t c = 0; c < GlyphCount; c++) {
+    const FONT_CHAR_INFO *info = &ActiveFontCharInfo[c];
+    const uint8_t *bitmap = iaActiveFont + info->offset;
+    GlyphHeight[c] = min((int)info->height, LED_MATRIX_HEIGHT);
+
+    for (uint8_t row = 0; row < GlyphHeight[c]; row++) {
+      // glyph rows have 1 byte, or 2 bytes if wider than 8 pixels
+      uint32_t bits = *bitmap++ << 16;
+      if (info->width > 8)
+        bits |= *bitmap++ << 8;
+      for (uint8_t shift = 0; shift < 8; shift++) {
+        GlyphCache[c][shift][row][0] = (bits >> shift) >> 16;
+        GlyphCache[c][shift][row][1] = (bits >> shift) >> 8;
+        GlyphCache[c][shift][row][2] = bits >> shift;
+      }
+    }
+  }
+}
+
+void setMatrixIRQ() {
+  xTaskNotify(irqHandlerTask, MATRIX_DISPLAY_IRQ, eSetBits);
+}
+
 void init_matrix_display(bool reverse) {
   ESP_LOGI(TAG, "Initializing LED Matrix display");
   matrix.begin(displaybuf, LED_MATRIX_WIDTH, LED_MATRIX_HEIGHT);
+  BuildGlyphCache();
 
-  if (MatrixDisplayIsOn)
-    matrix.on();
-  else
-    matrix.off();
-
+  scan_on = MatrixDisplayIsOn;
   if (reverse)
-    matrix.reverse();
+    scan_mask = ~scan_mask;
   matrix.clear();
   matrix.drawPoint(0, LED_MATRIX_HEIGHT - 1, 1);
+  memcpy(scanbuf, displaybuf, sizeof(scanbuf));
 } // dp_init
 
+// multiplex one row of scanbuf to the matrix, called by hardware timer.
+// Same sequence as LEDMatrix::scan(), but with direct GPIO register writes,
+// so it can run in interrupt context without the irqHandler task.
+void IRAM_ATTR MatrixScanIRQ() {
+  static uint8_t row = 0;
+  const uint8_t bytes = LED_MATRIX_WIDTH / 8;
+
+  if (!scan_on) {
+    gpio_ll_set_level(&GPIO, LED_MATRIX_EN_74138, 1); // LEDs off
+    return;
+  }
+
+  // shift out columns of current row for each 16 rows block
+  const uint8_t *head = scanbuf + row * bytes;
+  for (uint8_t block = 0; block < (LED_MATRIX_HEIGHT >> 4); block++) {
+    const uint8_t *ptr = head;
+    head += bytes * 16;
+    for (uint8_t i = 0; i < bytes; i++) {
+      uint8_t pixels = *ptr++ ^ scan_mask;
+      for (uint8_t bit = 0x80; bit; bit >>= 1) {
+        gpio_ll_set_level(&GPIO, LED_MATRIX_CLOCKPIN, 0);
+        gpio_ll_set_level(&GPIO, LED_MATRIX_DATA_R1, (pixels & bit) ? 1 : 0);
+        gpio_ll_set_level(&GPIO, LED_MATRIX_CLOCKPIN, 1);
+      }
+    }
+  }
+
+  // switch to row, latch columns
+  gpio_ll_set_level(&GPIO, LED_MATRIX_EN_74138, 1);
+  gpio_ll_set_level(&GPIO, LED_MATRIX_LA_74138, row & 0x01);
+  gpio_ll_set_level(&GPIO, LED_MATRIX_LB_74138, (row >> 1) & 0x01);
+  gpio_ll_set_level(&GPIO, LED_MATRIX_LC_74138, (row >> 2) & 0x01);
+  gpio_ll_set_level(&GPIO, LED_MATRIX_LD_74138, (row >> 3) & 0x01);
+  gpio_ll_set_level(&GPIO, LED_MATRIX_LATCHPIN, 0);
+  gpio_ll_set_level(&GPIO, LED_MATRIX_LATCHPIN, 1);
+  gpio_ll_set_level(&GPIO, LED_MATRIX_EN_74138, 0);
+
+  row = (row + 1) & 0x0f;
+}
+
 void refreshTheMatrixDisplay(bool nextPage) {
-  static uint8_t DisplayPage = 0, col = 0, row = 0;
-  uint8_t level;
+  static uint8_t DisplayPage = 0;
 
   // if Matrixdisplay is switched off we don't refresh it to relax cpu
   if (!MatrixDisplayIsOn && (MatrixDisplayIsOn == cfg.screenon))
@@ -54,17 +132,14 @@ void refreshTheMatrixDisplay(bool nextPage) {
   // set display on/off according to current device configuration
   if (MatrixDisplayIsOn != cfg.screenon) {
     MatrixDisplayIsOn = cfg.screenon;
-    if (MatrixDisplayIsOn)
-      matrix.on();
-    else
-      matrix.off();
+    scan_on = MatrixDisplayIsOn;
   }
 
   if (nextPage) {
     DisplayPage =
         (DisplayPage >= MATRIX_DISPLAY_PAGES - 1) ? 0 : (DisplayPage + 1);
     matrix.clear();
-    col = 0;
+    ulLastGraph = paxgraph_revision() - 1; // redraw
   }
 
   switch (DisplayPage % MATRIX_DISPLAY_PAGES) {
@@ -81,29 +156,15 @@ void refreshTheMatrixDisplay(bool nextPage) {
       if (ulLastNumMacs != count.pax) {
         ulLastNumMacs = count.pax;
         matrix.clear();
-        DrawNumber(String(ulLastNumMacs));
+        DrawNumber(ulLastNumMacs);
       }
     }
 
     else { // cyclic counter mode -> plot a line diagram
-      if (ulLastNumMacs != count.pax) {
-        // next count cycle?
-        if (count.pax == 0) {
-          // matrix full? then scroll left 1 dot, else increment column
-          if (col < (LED_MATRIX_WIDTH - 1))
-            col++;
-          else
-            ScrollMatrixLeft(displaybuf, LED_MATRIX_WIDTH, LED_MATRIX_HEIGHT);
-        } else
-          matrix.drawPoint(col, row, 0); // clear current dot
-
-        // scale and set new dot
-        ulLastNumMacs = count.pax;
-        level = ulLastNumMacs / LINE_DIAGRAM_DIVIDER;
-        row = level <= LED_MATRIX_HEIGHT
-                  ? LED_MATRIX_HEIGHT - 1 - level % LED_MATRIX_HEIGHT
-                  : 0;
-        matrix.drawPoint(col, row, 1);
+      paxgraph_live(count.pax);
+      if (ulLastGraph != paxgraph_revision()) {
+        ulLastGraph = paxgraph_revision();
+        DrawGraph(PAXGRAPH_CYCLE);
       }
     }
     break;
@@ -119,15 +180,21 @@ void refreshTheMatrixDisplay(bool nextPage) {
     break;
   } // switch page
 
-  matrix.scan();
+  // hand over changed content to scan interrupt
+  if (memcmp(scanbuf, displaybuf, sizeof(scanbuf)))
+    memcpy(scanbuf, displaybuf, sizeof(scanbuf));
 }
 
-// (x, y) top-left position, x should be multiple of 8
+// (x, y) top-left position
 void DrawChar(uint16_t x, uint16_t y, char cChar) {
-  // Get address of char in font char descriptor from font descriptor
-  auto CharDescAddress = (cChar - ActiveFontInfo->StartChar);
-  // Get offset of char into font bitmap
-  uint16_t FontBitmapOffset = ActiveFontCharInfo[CharDescAddress].offset;
+  const uint8_t bytes = LED_MATRIX_WIDTH / 8;
+
+  if ((cChar < ActiveFontInfo->StartChar) ||
+      (cChar - ActiveFontInfo->StartChar >= GlyphCount) ||
+      (x >= LED_MATRIX_WIDTH))
+    return;
+  const uint8_t c = cChar - ActiveFontInfo->StartChar;
+
   // Check font height, if it's less than matrix height we need to
   // add some empty lines to font does not stick to the top
   if (ActiveFontInfo->CharHeight < (LED_MATRIX_HEIGHT - y)) {
@@ -139,50 +206,41 @@ void DrawChar(uint16_t x, uint16_t y, char cChar) {
     }
   }
 
-  int iDst = (x / 8) + (y * 8);
-  int Shift = x % 8;
-  for (uint8_t i = 0; i < ActiveFontCharInfo[CharDescAddress].height; i++) {
-    int iDigitA = iaActiveFont[FontBitmapOffset];
-
-    int Left = iDigitA >> Shift;
-    int Right = iDigitA << (8 - Shift);
-
-    displaybuf[iDst] |= Left;
-    displaybuf[iDst + 1] |= Right;
-
-    if (ActiveFontCharInfo[CharDescAddress].width > 8) {
-      int iDigitB = iaActiveFont[FontBitmapOffset + 1];
-      Left = iDigitB >> Shift;
-      Right = iDigitB << (8 - Shift);
-
-      displaybuf[iDst + 1] |= Left;
-      displaybuf[iDst + 2] |= Right;
-      FontBitmapOffset++;
-    }
-
-    FontBitmapOffset++;
-    iDst += 8;
-  }
+  // OR pre-shifted glyph rows into display buffer, clipped at right border
+  const uint8_t(*glyph)[3] = GlyphCache[c][x % 8];
+  const uint8_t n = min(3, bytes - x / 8);
+  uint8_t *dst = displaybuf + y * bytes + x / 8;
+  for (uint8_t i = 0; (i < GlyphHeight[c]) && (y + i < LED_MATRIX_HEIGHT);
+       i++, dst += bytes)
+    for (uint8_t j = 0; j < n; j++)
+      dst[j] |= glyph[i][j];
 }
 
-void DrawNumber(String strNum, uint8_t iDotPos) {
-  uint8_t iNumLength = strNum.length();
-  uint8_t iDigitPos = 0;
+void DrawString(const char *str, uint8_t iDotPos) {
+  uint16_t iDigitPos = 0;
 
-  for (int i = 0; i < iNumLength; i++) {
-    DrawChar(iDigitPos, 0, strNum.charAt(i));
+  for (uint8_t i = 0; str[i]; i++) {
+    DrawChar(iDigitPos, 0, str[i]);
+    iDigitPos += GetCharWidth(str[i]) + ActiveFontInfo->SpaceWidth;
     if (i + 1 == iDotPos) {
-      iDigitPos = iDigitPos + GetCharWidth(strNum.charAt(i)) +
-                  ActiveFontInfo->SpaceWidth;
       DrawChar(iDigitPos, 0, '.');
-      iDigitPos = iDigitPos + GetCharWidth('.') + ActiveFontInfo->SpaceWidth;
-    } else {
-      iDigitPos = iDigitPos + GetCharWidth(strNum.charAt(i)) +
-                  ActiveFontInfo->SpaceWidth;
+      iDigitPos += GetCharWidth('.') + ActiveFontInfo->SpaceWidth;
     }
   }
 }
 
+// draw decimal number, without heap allocation
+void DrawNumber(uint32_t number, uint8_t iDotPos) {
+  char buf[11], *p = buf + sizeof(buf) - 1;
+
+  *p = 0;
+  do {
+    *--p = '0' + number % 10;
+    number /= 10;
+  } while (number);
+  DrawString(p, iDotPos);
+}
+
 uint8_t GetCharFromFont(char cChar) {
   auto cStartChar = ActiveFontInfo->StartChar;
   auto iCharLocation = cChar - cStartChar;
@@ -199,18 +257,18 @@ uint8_t GetCharWidth(char cChar) {
   return CharDescriptor.width;
 }
 
-void ScrollMatrixLeft(uint8_t *buf, const uint16_t cols, const uint16_t rows) {
-  uint32_t i, k, idx = 0;
-  const uint32_t x = cols / 8;
+// plot pax graph of a zoom level, scaled to fit matrix height
+void DrawGraph(uint8_t zoom) {
+  uint16_t values[LED_MATRIX_WIDTH];
+  uint16_t n = paxgraph_get(zoom, values, LED_MATRIX_WIDTH);
+  uint32_t scale = max((uint32_t)paxgraph_max(values, n),
+                       (uint32_t)(LED_MATRIX_HEIGHT - 1) * LINE_DIAGRAM_DIVIDER);
 
-  for (k = 0; k < rows; k++) {
-    // scroll a line with x bytes one dot to the left
-    for (i = 0; i < x - 1; ++i) {
-      idx = i + k * x;
-      buf[idx] = (buf[idx] << 1) | ((buf[idx + 1] >> 7) & 1);
-    }
-    buf[idx + 1] <<= 1;
-  }
+  matrix.clear();
+  for (uint16_t x = 0; x < n; x++)
+    matrix.drawPoint(x, LED_MATRIX_HEIGHT - 1 -
+                            values[x] * (LED_MATRIX_HEIGHT - 1) / scale,
+                     1);
 }
 
 #endif // HAS_MATRIX_DISPLAY
\ No newline at end of file
@@ -0,0 +1,170 @@
+// Basic Config
+#if (HAS_LORA)
+#include "lorawan.h"
+
+/* local datarate selection, used if ADR is off
+
+Keeps the SNR of the last downlinks (including acks) and the gateway margin of
+link check answers, and selects the fastest 125kHz datarate where the weakest
+sample still is LORA_LINKADAPT_MARGIN dB above the demodulation floor of the
+datarate's spreading factor. A link check is requested with every
+LORA_LINKADAPT_CHECK-th uplink without a sample in between, so samples are
+also collected if the device sends unconfirmed and gets no downlinks. The
+datarate goes up one step per downlink, but goes down at once if the margin is
+lost. A missed ack of a confirmed uplink steps down one datarate and clears
+the history.
+
+The same algorithm is implemented in src/LoRa/linksim.py for replaying
+recorded link traces offline, keep both in sync.
+*/
+
+static int8_t snr_hist[LINKADAPT_HISTORY]; // [dB/4], as LMIC.snr
+static uint8_t hist_count = 0, hist_next = 0;
+static uint8_t unsampled = 0; // uplinks since last sample
+
+// payload length of downlink MAC commands (LoRaWAN 1.0.3), -1 = unknown
+static int8_t mac_cmd_len(uint8_t cmd) {
+  switch (cmd) {
+  case 0x02: // LinkCheckAns
+    return 2;
+  case 0x03: // LinkADRReq
+  case 0x05: // RXParamSetupReq
+  case 0x0A: // DlChannelReq
+    return 4;
+  case 0x04: // DutyCycleReq
+  case 0x08: // RXTimingSetupReq
+  case 0x09: // TxParamSetupReq
+    return 1;
+  case 0x06: // DevStatusReq
+    return 0;
+  case 0x07: // NewChannelReq
+  case 0x0D: // DeviceTimeAns
+    return 5;
+  default:
+    return -1;
+  }
+}
+
+// LinkCheckAns in FOpts of last downlink, LMIC does not keep its values
+static bool linkcheck_answer(uint8_t *margin, uint8_t *gateways) {
+  uint8_t olen = LMIC.frame[OFF_DAT_FCT] & FCT_OPTLEN;
+  const uint8_t *opts = LMIC.frame + OFF_DAT_OPTS;
+
+  if (OFF_DAT_OPTS + olen > LMIC.dataBeg)
+    return false;
+  for (uint8_t i = 0; i < olen;) {
+    int8_t len = mac_cmd_len(opts[i]);
+    if (len < 0 || i + 1 + len > olen)
+      return false;
+    if (opts[i] == 0x02) {
+      *margin = opts[i + 1];
+      *gateways = opts[i + 2];
+      return true;
+    }
+    i += 1 + len;
+  }
+  return false;
+}
+
+// demodulation floor of a spreading factor [dB/4], SF7 = -7.5dB ... SF12 =
+// -20dB
+static int16_t sf_floor(rps_t rps) {
+  return -(30 + 10 * (getSf(rps) - SF7));
+}
+
+static bool usable(dr_t dr) {
+  rps_t rps = updr2rps(dr);
+  return validDR(dr) && getSf(rps) != FSK && getBw(rps) == BW125;
+}
+
+// next usable datarate in direction step (+1 = faster, -1 = slower), if any
+static bool neighbour(dr_t dr, int step, dr_t *next) {
+  int best = -1;
+  for (int d = 0; d < 16; d++) {
+    if (!usable(d))
+      continue;
+    int diff = (getSf(updr2rps(dr)) - getSf(updr2rps(d))) * step;
+    if (diff > 0 && (best < 0 || getSf(updr2rps(d)) * step >
+                                     getSf(updr2rps(best)) * step))
+      best = d;
+  }
+  if (best < 0)
+    return false;
+  *next = best;
+  return true;
+}
+
+static void linkadapt_set(dr_t dr, const char *reason) {
+  ESP_LOGI(TAG, "Link adaptation: %s -> %s (%s)",
+           getSfName(updr2rps(LMIC.datarate)), getSfName(updr2rps(dr)),
+           reason);
+  LMIC_setDrTxpow(dr, KEEP_TXPOW);
+}
+
+void linkadapt_reset(void) { hist_count = hist_next = unsampled = 0; }
+
+// request a link check if we got no samples for a while, called before an
+// uplink is queued
+void linkadapt_txstart(void) {
+#if (LORA_LINKADAPT_CHECK)
+  if (++unsampled >= LORA_LINKADAPT_CHECK) {
+    unsampled = 0;
+    LMIC_setLinkCheckRequestOnce();
+  }
+#endif
+}
+
+static void linkadapt_sample(int8_t snr) {
+  unsampled = 0;
+  snr_hist[hist_next] = snr;
+  hist_next = (hist_next + 1) % LINKADAPT_HISTORY;
+  if (hist_count < LINKADAPT_HISTORY)
+    hist_count++;
+
+  dr_t dr = LMIC.datarate, next;
+  if (!usable(dr))
+    return;
+
+  // weakest sample of history
+  int16_t worst = snr;
+  for (int i = 0; i < hist_count; i++)
+    worst = min(worst, (int16_t)snr_hist[i]);
+  const int16_t margin = LORA_LINKADAPT_MARGIN * 4;
+
+  if (worst - sf_floor(updr2rps(dr)) < margin) {
+    // margin lost, go down until we have it again or reach slowest
+    while (neighbour(dr, -1, &next)) {
+      dr = next;
+      if (worst - sf_floor(updr2rps(dr)) >= margin)
+        break;
+    }
+    if (dr != LMIC.datarate)
+      linkadapt_set(dr, "margin lost");
+  } else if (hist_count >= LINKADAPT_MINSAMPLES && neighbour(dr, +1, &next) &&
+             worst - sf_floor(updr2rps(next)) >= margin)
+    linkadapt_set(next, "margin sufficient");
+}
+
+// evaluate result of an uplink, called on EV_TXCOMPLETE
+void linkadapt_txcomplete(void) {
+  if (LMIC.txrxFlags & TXRX_NACK) {
+    dr_t next;
+    linkadapt_reset();
+    if (neighbour(LMIC.datarate, -1, &next))
+      linkadapt_set(next, "ack missed");
+  } else if (LMIC.txrxFlags & (TXRX_DNW1 | TXRX_DNW2)) {
+    uint8_t margin, gateways;
+    // the gateway margin is what the uplink datarate depends on, thus it is
+    // preferred over downlink SNR; map it to SNR at the datarate sent with
+    if (linkcheck_answer(&margin, &gateways)) {
+      ESP_LOGD(TAG, "Link check: margin %u dB, %u gateway(s)", margin,
+               gateways);
+      if (gateways)
+        linkadapt_sample(min(127, sf_floor(updr2rps(LMIC.datarate)) +
+                                      4 * margin));
+    } else
+      linkadapt_sample(LMIC.snr);
+  }
+}
+
+#endif // HAS_LORA
@@ -2,6 +2,7 @@
 
 #if (HAS_LORA)
 #include "lorawan.h"
+#include "led.h"
 
 
 #if CLOCK_ERROR_PROCENTAGE > 7
@@ -18,6 +19,22 @@ static QueueHandle_t LoraSendQueue;
 TaskHandle_t lmicTask = NULL, lorasendTask = NULL;
 char lmic_event_msg[LMIC_EVENTMSG_LEN]; // display buffer for LMIC event message
 
+// message handed over to LMIC, until EV_TXCOMPLETE
+static volatile bool lora_txpending = false;
+static bool lora_txconfirmed = false;
+static MessageBuffer_t lora_txmsg;
+static uint32_t lora_txstarted; // [ms]
+
+// confirmed uplink policy state
+static uint16_t lora_unconfirmed = 0;       // uplinks since last confirmed
+static uint32_t lora_lastdownlink = 0;      // [ms]
+static uint8_t lora_missed = 0;             // consecutive missed acks
+static uint8_t lora_retries = 0;            // retries of current message
+static volatile bool lora_retry = false;    // queue front is a retry
+static volatile uint32_t lora_retry_at = 0; // [ms] earliest time of retry
+static uint32_t lora_budget_start = 0;      // [ms] start of budget hour
+static uint32_t lora_budget_used = 0;       // [ms] retry airtime this hour
+
 class MyHalConfig_t : public Arduino_LMIC::HalConfiguration_t {
 public:
   MyHalConfig_t(){};
@@ -71,6 +88,9 @@ void lora_setupForNetwork(bool preJoin) {
     // set data rate and transmit power to stored device values if no ADR
     if (!cfg.adrmode)
       LMIC_setDrTxpow(assertDR(cfg.loradr), cfg.txpower);
+#if (LORA_LINKADAPT)
+    linkadapt_reset();
+#endif
     // show current devaddr
     ESP_LOGI(TAG, "DEVaddr: 0x%08X | Network ID: 0x%06X | Network Type: %d",
              LMIC.devaddr, LMIC.netid & 0x001FFFFF, LMIC.netid & 0x00E00000);
@@ -189,6 +209,71 @@ void showLoraKeys(void) {
 
 #endif // VERBOSE
 
+// decide if next uplink is sent confirmed, in countermode 2 only every
+// LORA_CONFIRM_EVERY uplink and after LORA_CONFIRM_SILENCE minutes without
+// downlink
+static bool lora_confirm(void) {
+  if (!(cfg.countermode & 0x02))
+    return false;
+  if (lora_unconfirmed + 1 >= LORA_CONFIRM_EVERY)
+    return true;
+  return (LORA_CONFIRM_SILENCE &&
+          (millis() - lora_lastdownlink >= LORA_CONFIRM_SILENCE * 60000UL));
+}
+
+// confirmed uplink was not acknowledged, send it again after a backoff time
+// as long as the hourly retry airtime budget allows, rejoin after
+// LORA_REJOIN_FAILS missed acks in a row
+static void lora_missedack(void) {
+  uint32_t now = millis();
+
+  if (LORA_REJOIN_FAILS && ++lora_missed >= LORA_REJOIN_FAILS) {
+    ESP_LOGW(TAG, "%u acks missed in a row", lora_missed);
+    lora_missed = 0;
+#ifndef LORA_ABP
+    ESP_LOGI(TAG, "Rejoining network");
+    route_setlink(TRANSPORT_LORA, false);
+    LMIC_unjoinAndRejoin();
+#endif
+  }
+
+  if (now - lora_budget_start >= 3600000UL) {
+    lora_budget_start = now;
+    lora_budget_used = 0;
+  }
+  // airtime of frame, with 13 bytes LoRaWAN header and MIC
+  uint32_t airtime = osticks2ms(
+      calcAirTime(updr2rps(LMIC.datarate), lora_txmsg.MessageSize + 13));
+
+  if (lora_budget_used + airtime > LORA_RETRY_BUDGET * 1000UL) {
+    ESP_LOGW(TAG, "Retry airtime budget exhausted, message dropped");
+    stats_dropped(TRANSPORT_LORA);
+    lora_retries = 0;
+    return;
+  }
+
+  // exponential backoff with random spread, set before the message is back
+  // in the queue, else lora_send() takes it at once
+  uint32_t backoff = (LORA_RETRY_BACKOFF * 1000UL) << min(lora_retries, (uint8_t)6);
+  backoff += random(backoff / 2);
+  lora_retry_at = now + backoff;
+  lora_retry = true;
+  if (xQueueSendToFront(LoraSendQueue, (void *)&lora_txmsg, (TickType_t)0) !=
+      pdTRUE) {
+    ESP_LOGW(TAG, "LORA sendqueue is full, message dropped");
+    stats_dropped(TRANSPORT_LORA);
+    lora_retry = false;
+    lora_retries = 0;
+    return;
+  }
+
+  lora_budget_used += airtime;
+  lora_retries++;
+  stats_retried(TRANSPORT_LORA, 1);
+  ESP_LOGI(TAG, "Ack missed, retry #%u in %u sec", lora_retries,
+           backoff / 1000);
+}
+
 // LMIC send task
 void lora_send(void *pvParameters) {
   _ASSERT((uint32_t)pvParameters == 1); // FreeRTOS check
@@ -208,10 +293,24 @@ void lora_send(void *pvParameters) {
       continue;
     }
 
-    // attempt to transmit payload
+    // postpone until backoff time of a retry has passed, checked after the
+    // peek, as the retry may have just woken us up
+    if (lora_retry) {
+      int32_t wait = lora_retry_at - millis();
+      if (wait > 0) {
+        vTaskDelay(pdMS_TO_TICKS(min(wait, (int32_t)1000)));
+        continue;
+      }
+    }
+
+    // attempt to transmit payload, retries are always confirmed
+    bool confirm = lora_retry || lora_confirm();
+#if (LORA_LINKADAPT)
+    if (!cfg.adrmode)
+      linkadapt_txstart();
+#endif
     switch (LMIC_setTxData2_strict(SendBuffer.MessagePort, SendBuffer.Message,
-                                   SendBuffer.MessageSize,
-                                   (cfg.countermode & 0x02))) {
+                                   SendBuffer.MessageSize, confirm)) {
     case LMIC_ERROR_SUCCESS:
 #if (TIME_SYNC_LORASERVER)
       // if last packet sent was a timesync request, store TX timestamp
@@ -220,6 +319,15 @@ void lora_send(void *pvParameters) {
         timesync_store(osticks2ms(os_getTime()), timesync_tx);
 #endif
       ESP_LOGI(TAG, "%d byte(s) sent to LORA", SendBuffer.MessageSize);
+      // remember message for send statistics and retry on EV_TXCOMPLETE
+      lora_txmsg = SendBuffer;
+      lora_txconfirmed = confirm;
+      lora_txstarted = millis();
+      lora_txpending = true;
+      lora_unconfirmed = confirm ? 0 : lora_unconfirmed + 1;
+      lora_retry = false;
+      lmic_wake();
+      led_wake();
       // delete sent item from queue
       xQueueReceive(LoraSendQueue, &SendBuffer, (TickType_t)0);
       break;
@@ -229,16 +337,20 @@ void lora_send(void *pvParameters) {
       break;
     case LMIC_ERROR_TX_FAILED: // message was not sent
       ESP_LOGV(TAG, "Message not sent, TX failed, will retry later");
+      stats_retried(TRANSPORT_LORA, 1);
       vTaskDelay(pdMS_TO_TICKS(500 + random(400))); // wait a while
       break;
     case LMIC_ERROR_TX_TOO_LARGE:    // message size exceeds LMIC buffer size
     case LMIC_ERROR_TX_NOT_FEASIBLE: // message too large for current
                                      // datarate
       ESP_LOGI(TAG, "Message too large to send, message not sent and deleted");
-      // we need some kind of error handling here -> to be done
+      stats_toolarge(TRANSPORT_LORA);
+      xQueueReceive(LoraSendQueue, &SendBuffer, (TickType_t)0);
       break;
     default: // other LMIC return code
       ESP_LOGE(TAG, "LMIC error, message not sent and deleted");
+      stats_dropped(TRANSPORT_LORA);
+      xQueueReceive(LoraSendQueue, &SendBuffer, (TickType_t)0);
     }         // switch
     delay(2); // yield to CPU
   }           // while(1)
@@ -246,7 +358,7 @@ void lora_send(void *pvParameters) {
 
 esp_err_t lmic_init(void) {
   _ASSERT(SEND_QUEUE_SIZE > 0);
-  LoraSendQueue = xQueueCreate(SEND_QUEUE_SIZE, sizeof(MessageBuffer_t));
+  LoraSendQueue = QUEUE_CREATE(SEND_QUEUE_SIZE, sizeof(MessageBuffer_t));
   if (LoraSendQueue == 0) {
     ESP_LOGE(TAG, "Could not create LORA send queue. Aborting.");
     return ESP_FAIL;
@@ -294,30 +406,43 @@ esp_err_t lmic_init(void) {
   // Pass OTA parameters to LMIC_setSession
 #else
   // load saved session from RTC, if we have one
-  if (RTC_runmode == RUNMODE_WAKEUP)
+  if (RTC_runmode == RUNMODE_WAKEUP) {
     LoadLMICFromRTC();
+#if (LORA_SESSION_PERSIST)
+    lora_session_resume();
+#endif
+  }
+#if (LORA_SESSION_PERSIST)
+  // otherwise load saved session from NVRAM, if we have one
+  else if (lora_session_restore())
+    lora_setupForNetwork(false);
+#endif
   if (!LMIC_startJoining())
     ESP_LOGI(TAG, "Already joined");
 #endif
 
+  // we have a session, if we use ABP or restored it from RTC
+  if (LMIC.devaddr)
+    route_setlink(TRANSPORT_LORA, true);
+
   // start lmic loop task
   ESP_LOGI(TAG, "Starting LMIC...");
-  xTaskCreatePinnedToCore(lmictask,   // task function
-                          "lmictask", // name of task
-                          4096,       // stack size of task
-                          (void *)1,  // parameter of the task
-                          2,          // priority of the task
-                          &lmicTask,  // task handle
-                          1);         // CPU core
+  TASK_CREATE(lmictask,   // task function
+              "lmictask", // name of task
+              4096,       // stack size of task
+              (void *)1,  // parameter of the task
+              2,          // priority of the task
+              &lmicTask,  // task handle
+              1);         // CPU core
 
   // start lora send task
-  xTaskCreatePinnedToCore(lora_send,      // task function
-                          "lorasendtask", // name of task
-                          3072,           // stack size of task
-                          (void *)1,      // parameter of the task
-                          2,              // priority of the task
-                          &lorasendTask,  // task handle
-                          1);             // CPU core
+  TASK_CREATE(lora_send,      // task function
+              "lorasendtask", // name of task
+              3072,           // stack size of task
+              (void *)1,      // parameter of the task
+              2,              // priority of the task
+              &lorasendTask,  // task handle
+              1);             // CPU core
 
   return ESP_OK;
 }
@@ -328,14 +453,19 @@ void lora_enqueuedata(MessageBuffer_t *message) {
       pdTRUE) {
     snprintf(lmic_event_msg + 14, LMIC_EVENTMSG_LEN - 14, "<>");
     ESP_LOGW(TAG, "LORA sendqueue is full");
+    stats_dropped(TRANSPORT_LORA);
   } else {
+    UBaseType_t waiting = uxQueueMessagesWaiting(LoraSendQueue);
+    stats_enqueued(TRANSPORT_LORA, waiting);
     // add Lora send queue length to display
-    snprintf(lmic_event_msg + 14, LMIC_EVENTMSG_LEN - 14, "%2u",
-             uxQueueMessagesWaiting(LoraSendQueue));
+    snprintf(lmic_event_msg + 14, LMIC_EVENTMSG_LEN - 14, "%2u", waiting);
   }
 }
 
-void lora_queuereset(void) { xQueueReset(LoraSendQueue); }
+void lora_queuereset(void) {
+  xQueueReset(LoraSendQueue);
+  lora_retry = false;
+}
 
 uint32_t lora_queuewaiting(void) {
   return uxQueueMessagesWaiting(LoraSendQueue);
@@ -356,12 +486,39 @@ void lora_waitforidle(uint16_t timeout_sec) {
 // LMIC loop task
 void lmictask(void *pvParameters) {
   _ASSERT((uint32_t)pvParameters == 1);
+  uint32_t busy = millis();
+  pm_hold(PM_RADIO, true);
+
   while (1) {
+    // radio active or job due, LMIC may queue further jobs, so keep polling
+    if ((LMIC.opmode & OP_TXRXPEND) ||
+        os_queryTimeCriticalJobs(ms2osticks(2)))
+      busy = millis();
+
     os_runloop_once(); // execute lmic scheduled jobs and events
-    delay(2);          // yield to CPU
+
+    if (millis() - busy < LMIC_BUSY_MS) {
+      delay(2); // yield to CPU
+      continue;
+    }
+
+    // LMIC idle: sleep until the next scheduled job is due or lmic_wake()
+    uint32_t ms = LMIC_IDLE_MS;
+    while (ms > 2 && os_queryTimeCriticalJobs(ms2osticks(ms)))
+      ms /= 4;
+    pm_hold(PM_RADIO, false);
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms)))
+      busy = millis();
+    pm_hold(PM_RADIO, true);
   }
 }
 
+// LMIC API was called from another task, let lmictask run its jobs now
+void lmic_wake(void) {
+  if (lmicTask != NULL)
+    xTaskNotifyGive(lmicTask);
+}
+
 // lmic event handler
 void myEventCallback(void *pUserData, ev_t ev) {
   // using message descriptors from LMIC library
@@ -376,10 +533,34 @@ void myEventCallback(void *pUserData, ev_t ev) {
   else
     snprintf(lmic_event_msg, LMIC_EVENTMSG_LEN, "LMIC event %-4u ", ev);
 
+  // LED shows join and transmit state
+  led_wake();
+
   // process current event message
   switch (ev) {
   case EV_TXCOMPLETE:
     // -> processed in lora_send()
+    if (LMIC.txrxFlags & (TXRX_DNW1 | TXRX_DNW2)) {
+      lora_lastdownlink = millis();
+      lora_missed = 0;
+    }
+    if (lora_txpending) {
+      lora_txpending = false;
+      if (lora_txconfirmed && (LMIC.txrxFlags & TXRX_NACK))
+        lora_missedack();
+      else {
+        stats_sent(TRANSPORT_LORA, lora_txmsg.MessageTime, lora_txstarted);
+        lora_retries = 0;
+      }
+    }
+#if (LORA_SESSION_PERSIST) && !defined(LORA_ABP)
+    lora_session_update();
+#endif
+#if (LORA_LINKADAPT)
+    // select datarate by link quality, if ADR is off
+    if (!cfg.adrmode)
+      linkadapt_txcomplete();
+#endif
     break;
 
   case EV_RXCOMPLETE:
@@ -394,12 +575,26 @@ void myEventCallback(void *pUserData, ev_t ev) {
   case EV_JOINED:
     // do the after join network-specific setup.
     lora_setupForNetwork(false);
+    route_setlink(TRANSPORT_LORA, true);
+#if (LORA_SESSION_PERSIST) && !defined(LORA_ABP)
+    lora_session_save();
+#endif
     break;
 
   case EV_JOIN_FAILED:
     // must call LMIC_reset() to stop joining
     // otherwise join procedure continues.
     LMIC_reset();
+    route_setlink(TRANSPORT_LORA, false);
+    break;
+
+  case EV_LINK_DEAD:
+  case EV_RESET:
+    route_setlink(TRANSPORT_LORA, false);
+    break;
+
+  case EV_LINK_ALIVE:
+    route_setlink(TRANSPORT_LORA, true);
     break;
 
   case EV_JOIN_TXCOMPLETE:
@@ -482,17 +677,29 @@ const char *getCrName(rps_t rps) {
 RTC_DATA_ATTR uint8_t ttn_rtc_mem_buf[TTN_RTC_MEM_SIZE];
 RTC_DATA_ATTR uint32_t ttn_rtc_flag;
 
-void ttn_rtc_save() {
+static void ttn_lmic_pack(uint8_t *buf) {
   // Copy LMIC struct except client, osjob, pendTxData and frame
   size_t len1 = LMIC_DIST(radio, pendTxData);
-  memcpy(ttn_rtc_mem_buf, &LMIC.radio, len1);
+  memcpy(buf, &LMIC.radio, len1);
   size_t len2 = LMIC_DIST(pendTxData, frame) - MAX_LEN_PAYLOAD;
-  memcpy(ttn_rtc_mem_buf + len1, (u1_t *)&LMIC.pendTxData + MAX_LEN_PAYLOAD,
-         len2);
+  memcpy(buf + len1, (u1_t *)&LMIC.pendTxData + MAX_LEN_PAYLOAD, len2);
   size_t len3 = sizeof(struct lmic_t) - LMIC_OFFSET(frame) - MAX_LEN_FRAME;
-  memcpy(ttn_rtc_mem_buf + len1 + len2, (u1_t *)&LMIC.frame + MAX_LEN_FRAME,
-         len3);
+  memcpy(buf + len1 + len2, (u1_t *)&LMIC.frame + MAX_LEN_FRAME, len3);
+}
 
+static void ttn_lmic_unpack(const uint8_t *buf) {
+  size_t len1 = LMIC_DIST(radio, pendTxData);
+  memcpy(&LMIC.radio, buf, len1);
+  memset(LMIC.pendTxData, 0, MAX_LEN_PAYLOAD);
+  size_t len2 = LMIC_DIST(pendTxData, frame) - MAX_LEN_PAYLOAD;
+  memcpy((u1_t *)&LMIC.pendTxData + MAX_LEN_PAYLOAD, buf + len1, len2);
+  memset(LMIC.frame, 0, MAX_LEN_FRAME);
+  size_t len3 = sizeof(struct lmic_t) - LMIC_OFFSET(frame) - MAX_LEN_FRAME;
+  memcpy((u1_t *)&LMIC.frame + MAX_LEN_FRAME, buf + len1 + len2, len3);
+}
+
+void ttn_rtc_save() {
+  ttn_lmic_pack(ttn_rtc_mem_buf);
   ttn_rtc_flag = TTN_RTC_FLAG_VALUE;
 }
 
@@ -501,16 +708,7 @@ bool ttn_rtc_restore() {
     return false;
 
   // Restore data
-  size_t len1 = LMIC_DIST(radio, pendTxData);
-  memcpy(&LMIC.radio, ttn_rtc_mem_buf, len1);
-  memset(LMIC.pendTxData, 0, MAX_LEN_PAYLOAD);
-  size_t len2 = LMIC_DIST(pendTxData, frame) - MAX_LEN_PAYLOAD;
-  memcpy((u1_t *)&LMIC.pendTxData + MAX_LEN_PAYLOAD, ttn_rtc_mem_buf + len1,
-         len2);
-  memset(LMIC.frame, 0, MAX_LEN_FRAME);
-  size_t len3 = sizeof(struct lmic_t) - LMIC_OFFSET(frame) - MAX_LEN_FRAME;
-  memcpy((u1_t *)&LMIC.frame + MAX_LEN_FRAME, ttn_rtc_mem_buf + len1 + len2,
-         len3);
+  ttn_lmic_unpack(ttn_rtc_mem_buf);
 
   ttn_rtc_flag = 0xffffffff; // invalidate RTC data
 
@@ -560,4 +758,214 @@ void LoadLMICFromRTC() {
   }
 }
 
+#if (LORA_SESSION_PERSIST) && !defined(LORA_ABP)
+
+/* OTAA session persistence in NVRAM
+
+The LMIC state is saved after each join, so a device restarting after power
+loss or a coldstart can send at once, without joining again. It is saved
+again after a transmit, if MAC commands of the network changed channels,
+datarate, tx power or receive windows since. To spare the
+flash, the uplink frame counter is checkpointed only every
+LORA_SESSION_FCNT_STEP frames. On restore the counter is advanced by this
+step, so the device never reuses a frame counter the network has seen.
+After wakeup from deep sleep the LMIC state comes from RTC memory, but the
+checkpoint step continues from the counter last stored in NVRAM.
+
+LMIC events only take a copy of what is to be saved. The irq handler writes
+it to NVRAM, when no time critical LMIC jobs are due.
+*/
+
+#define LMICSESSION "lmicsess"
+
+static uint8_t session_buf[TTN_RTC_MEM_SIZE];
+static uint32_t session_fcnt = 0; // last checkpointed uplink frame counter
+
+static portMUX_TYPE session_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool session_packed = false;  // session_buf waits to be saved
+static bool session_writing = false; // session_buf is written to NVRAM
+static bool session_due = false;    // frame counters wait to be saved
+static uint32_t session_fcntup, session_fcntdn;
+// hash of MAC state in saved session, kept over deep sleep
+static RTC_DATA_ATTR uint32_t session_machash = 0;
+
+// hash over OTAA keys, to detect a changed device identity
+static uint32_t lora_session_keyhash(void) {
+  uint8_t keys[8 + 8 + 16];
+  os_getDevEui(keys);
+  os_getArtEui(keys + 8);
+  os_getDevKey(keys + 16);
+  return myhash((const char *)keys, sizeof(keys));
+}
+
+// hash over MAC state which the network may change after join
+static uint32_t lora_session_machash(void) {
+  uint8_t params[] = {LMIC.datarate, (uint8_t)LMIC.adrTxPow, LMIC.rxDelay,
+                      LMIC.rx1DrOffset, LMIC.dn2Dr};
+  uint32_t h = myhash((const char *)params, sizeof(params));
+  h = h * 31 + LMIC.dn2Freq;
+  h = h * 31 + myhash((const char *)&LMIC.channelMap, sizeof(LMIC.channelMap));
+#if CFG_LMIC_EU_like
+  h = h * 31 +
+      myhash((const char *)LMIC.channelFreq, sizeof(LMIC.channelFreq));
+  h = h * 31 +
+      myhash((const char *)LMIC.channelDrMap, sizeof(LMIC.channelDrMap));
+#endif
+  return h;
+}
+
+static void lora_session_checkpoint(uint32_t fcntup, uint32_t fcntdn) {
+  Preferences nvs;
+  if (!nvs.begin(LMICSESSION, false)) {
+    ESP_LOGE(TAG, "NVRAM Error, LORA frame counter not saved");
+    return;
+  }
+  nvs.putUInt("fcntup", fcntup);
+  nvs.putUInt("fcntdn", fcntdn);
+  nvs.end();
+  ESP_LOGD(TAG, "LORA frame counter checkpoint %u", fcntup);
+}
+
+// note frame counters of LMIC for next checkpoint, called in LMIC context
+static void lora_session_mark(void) {
+  portENTER_CRITICAL(&session_mux);
+  session_fcntup = session_fcnt = LMIC.seqnoUp;
+  session_fcntdn = LMIC.seqnoDn;
+  session_due = true;
+  portEXIT_CRITICAL(&session_mux);
+  if (irqHandlerTask != NULL)
+    xTaskNotify(irqHandlerTask, LORA_SESSION_IRQ, eSetBits);
+}
+
+// save LMIC session, called after join and after MAC state changed
+void lora_session_save(void) {
+  portENTER_CRITICAL(&session_mux);
+  bool writing = session_writing;
+  if (!writing)
+    session_packed = false; // irq handler must not write while we pack
+  portEXIT_CRITICAL(&session_mux);
+  if (writing)
+    return; // buffer in use, machash unchanged, so next transmit tries again
+
+  ttn_lmic_pack(session_buf);
+  session_machash = lora_session_machash();
+  portENTER_CRITICAL(&session_mux);
+  session_packed = true;
+  portEXIT_CRITICAL(&session_mux);
+  lora_session_mark();
+}
+
+// save session if MAC commands changed it, else checkpoint uplink frame
+// counter, called after each transmit
+void lora_session_update(void) {
+  if (!LMIC.devaddr)
+    return;
+  if (lora_session_machash() != session_machash)
+    lora_session_save();
+  else if (LMIC.seqnoUp - session_fcnt >= LORA_SESSION_FCNT_STEP)
+    lora_session_mark();
+}
+
+// write session and frame counters noted before to NVRAM, called by irq
+// handler when no time critical LMIC jobs are due
+void lora_session_store(void) {
+  uint32_t fcntup, fcntdn;
+  bool due;
+
+  portENTER_CRITICAL(&session_mux);
+  due = session_due;
+  session_due = false;
+  fcntup = session_fcntup;
+  fcntdn = session_fcntdn;
+  bool packed = session_packed;
+  session_packed = false;
+  session_writing = packed;
+  portEXIT_CRITICAL(&session_mux);
+
+  if (packed) {
+    Preferences nvs;
+    if (nvs.begin(LMICSESSION, false)) {
+      nvs.putUInt("keyhash", lora_session_keyhash());
+      if (nvs.putBytes("state", session_buf, sizeof(session_buf)) ==
+          sizeof(session_buf))
+        ESP_LOGI(TAG, "LORA session saved");
+      else
+        ESP_LOGE(TAG, "NVRAM Error, LORA session not saved");
+      nvs.end();
+    } else
+      ESP_LOGE(TAG, "NVRAM Error, LORA session not saved");
+    portENTER_CRITICAL(&session_mux);
+    session_writing = false;
+    portEXIT_CRITICAL(&session_mux);
+  }
+
+  if (due)
+    lora_session_checkpoint(fcntup, fcntdn);
+}
+
+// continue checkpoint steps after wakeup from deep sleep, where the LMIC
+// state comes from RTC memory
+void lora_session_resume(void) {
+  Preferences nvs;
+  if (nvs.begin(LMICSESSION, true)) {
+    session_fcnt = nvs.getUInt("fcntup", 0);
+    nvs.end();
+  }
+}
+
+// restore LMIC session saved before, returns true if we have a session
+bool lora_session_restore(void) {
+  Preferences nvs;
+  bool valid = false;
+  uint32_t fcntup = 0, fcntdn = 0;
+
+  if (nvs.begin(LMICSESSION, true)) {
+    valid = (nvs.getUInt("keyhash", 0) == lora_session_keyhash()) &&
+            (nvs.getBytes("state", session_buf, sizeof(session_buf)) ==
+             sizeof(session_buf));
+    fcntup = nvs.getUInt("fcntup", 0);
+    fcntdn = nvs.getUInt("fcntdn", 0);
+    nvs.end();
+  }
+
+  if (!valid) {
+    ESP_LOGI(TAG, "No saved LORA session found");
+    return false;
+  }
+
+  ttn_lmic_unpack(session_buf);
+  session_machash = lora_session_machash();
+
+  // skip frame counters which may have been used after last checkpoint
+  LMIC.seqnoUp = fcntup + LORA_SESSION_FCNT_STEP;
+  if (fcntdn > LMIC.seqnoDn)
+    LMIC.seqnoDn = fcntdn;
+
+  // drop pending operations and duty cycle times of the previous run
+  LMIC.opmode &= ~(OP_JOINING | OP_TXDATA | OP_POLL | OP_TXRXPEND);
+#if CFG_LMIC_EU_like
+  for (int i = 0; i < MAX_BANDS; i++)
+    LMIC.bands[i].avail = os_getTime();
+  LMIC.globalDutyAvail = os_getTime();
+#endif
+
+  // store advanced counter at once, in case we restart again before sending
+  session_fcnt = LMIC.seqnoUp;
+  lora_session_checkpoint(LMIC.seqnoUp, LMIC.seqnoDn);
+  ESP_LOGI(TAG, "LORA session restored, uplink frame counter %u",
+           LMIC.seqnoUp);
+  return true;
+}
+
+// forget saved session, device will join again on next start
+void lora_session_erase(void) {
+  Preferences nvs;
+  if (nvs.begin(LMICSESSION, false)) {
+    nvs.clear();
+    nvs.end();
+  }
+}
+
+#endif // LORA_SESSION_PERSIST
+
 #endif // HAS_LORA
\ No newline at end of file
@@ -27,21 +27,25 @@ licenses. Refer to LICENSE.txt file in repository for more details.
 
 Task          	Core  Prio  Purpose
 -------------------------------------------------------------------------------
-ledloop*      	1     1    blinks LEDs
-buttonloop*     1     2    reads button
+ledloop#      	1     1    blinks LEDs
+buttonloop#     1     2    reads button
 spiloop#      	0     2    reads/writes data on spi interface
 lmictask*     	1     2    MCCI LMiC LORAWAN stack
 clockloop#    	1     6    generates realtime telegrams for external clock
 mqttloop#     	1     5    reads/writes data on ETH interface
 timesync_proc#	1     7    processes realtime time sync requests
 irqhandler#   	1     4    application IRQ (i.e. displayrefresh)
-gpsloop*      	1     1    reads data from GPS via serial or i2c
+gpsloop#      	1     1    reads data from GPS via serial or i2c
 lorasendtask# 	1     2    feeds data from lora sendqueue to lmcic
 rmcd_process# 	1     1    Remote command interpreter loop
 
-* spinning task, always ready
+* spinning task while radio is active, else blocked/waiting
 # blocked/waiting task
 
+ledloop waits until next blink edge, buttonloop until the button pin
+interrupt, gpsloop until serial data arrives, lmictask until the next LMIC
+job is due. With POWER_MANAGEMENT the chip may light sleep in between.
+
 Low priority numbers denote low priority tasks.
 -------------------------------------------------------------------------------
 
@@ -49,8 +53,8 @@ Low priority numbers denote low priority tasks.
 -------------------------------------------------------------------------------
 0	displayIRQ -> display refresh -> 40ms (DISPLAYREFRESH_MS)
 1 ppsIRQ -> pps clock irq -> 1sec
-2 (unused)
-3	MatrixDisplayIRQ -> matrix mux cycle -> 0,5ms (MATRIX_DISPLAY_SCAN_US)
+2 clockTickIRQ -> DCF77/IF482 clock output tick -> 10ms
+3	MatrixScanIRQ -> matrix mux cycle -> 0,5ms (MATRIX_DISPLAY_SCAN_US)
 
 
 // External RTC timer (if present)
@@ -64,15 +68,17 @@ triggers pps 1 sec impulse
 ISRs fired by CPU or GPIO:
 DisplayIRQ      <- esp32 timer 0
 CLOCKIRQ        <- esp32 timer 1 or GPIO (RTC_INT)
-MatrixDisplayIRQ<- esp32 timer 3
+CLOCKTICKIRQ    <- esp32 timer 2
+MatrixScanIRQ   <- esp32 timer 3 (scans LED matrix, no irqHandler notify)
 ButtonIRQ       <- GPIO <- Button
 PMUIRQ          <- GPIO <- PMU chip
 
 Application IRQs fired by software:
-TIMESYNC_IRQ    <- setTimeSyncIRQ() <- Ticker.h
-CYCLIC_IRQ      <- setCyclicIRQ() <- Ticker.h
+TIMESYNC_IRQ    <- setTimeSyncIRQ() <- jobtimer
+CYCLIC_IRQ      <- setCyclicIRQ() <- jobtimer
 SENDCYCLE_IRQ   <- setSendIRQ() <- libpax callback
-BME_IRQ         <- setBMEIRQ() <- Ticker.h
+BME_IRQ         <- setBMEIRQ() <- jobtimer
+MATRIX_DISPLAY_IRQ <- setMatrixIRQ() <- jobtimer
 
 */
 
@@ -179,10 +185,6 @@ void setup() {
              ARDUINO_LMIC_VERSION_GET_LOCAL(ARDUINO_LMIC_VERSION));
     showLoraKeys();
 #endif // HAS_LORA
-
-#if (HAS_GPS)
-    ESP_LOGI(TAG, "TinyGPS+ version %s", TinyGPSPlus::libraryVersion());
-#endif
   }
 #endif // VERBOSE
 
@@ -253,13 +255,13 @@ void setup() {
 #if (HAS_LED != NOT_A_PIN) || defined(HAS_RGB_LED)
   // start led loop
   ESP_LOGI(TAG, "Starting LED Controller...");
-  xTaskCreatePinnedToCore(ledLoop,      // task function
-                          "ledloop",    // name of task
-                          1024,         // stack size of task
-                          (void *)1,    // parameter of the task
-                          1,            // priority of the task
-                          &ledLoopTask, // task handle
-                          1);           // CPU core
+  TASK_CREATE(ledLoop,      // task function
+              "ledloop",    // name of task
+              1024,         // stack size of task
+              (void *)1,    // parameter of the task
+              1,            // priority of the task
+              &ledLoopTask, // task handle
+              1);           // CPU core
 #endif
 
 // initialize wifi antenna
@@ -331,13 +333,13 @@ void setup() {
   strcat_P(features, " GPS");
   if (gps_init()) {
     ESP_LOGI(TAG, "Starting GPS Feed...");
-    xTaskCreatePinnedToCore(gps_loop,  // task function
-                            "gpsloop", // name of task
-                            8192,      // stack size of task
-                            (void *)1, // parameter of the task
-                            1,         // priority of the task
-                            &GpsTask,  // task handle
-                            1);        // CPU core
+    TASK_CREATE(gps_loop,  // task function
+                "gpsloop", // name of task
+                8192,      // stack size of task
+                (void *)1, // parameter of the task
+                1,         // priority of the task
+                &GpsTask,  // task handle
+                1);        // CPU core
   }
 #endif
 
@@ -415,13 +417,13 @@ void setup() {
 
   // start state machine
   ESP_LOGI(TAG, "Starting Interrupt Handler...");
-  xTaskCreatePinnedToCore(irqHandler,      // task function
-                          "irqhandler",    // name of task
-                          4096,            // stack size of task
-                          (void *)1,       // parameter of the task
-                          4,               // priority of the task
-                          &irqHandlerTask, // task handle
-                          1);              // CPU core
+  TASK_CREATE(irqHandler,      // task function
+              "irqhandler",    // name of task
+              4096,            // stack size of task
+              (void *)1,       // parameter of the task
+              4,               // priority of the task
+              &irqHandlerTask, // task handle
+              1);              // CPU core
 
 // initialize BME sensor (BME280/BME680)
 #if (HAS_BME)
@@ -463,9 +465,10 @@ void setup() {
   // https://techtutorialsx.com/2017/10/07/esp32-arduino-timer-interrupts/
   // prescaler 80 -> divides 80 MHz CPU freq to 1 MHz, timer 3, count up
   matrixDisplayIRQ = timerBegin(3, 80, true);
-  timerAttachInterrupt(matrixDisplayIRQ, &MatrixDisplayIRQ, false);
+  timerAttachInterrupt(matrixDisplayIRQ, &MatrixScanIRQ, false);
   timerAlarmWrite(matrixDisplayIRQ, MATRIX_DISPLAY_SCAN_US, true);
   timerAlarmEnable(matrixDisplayIRQ);
+  matrixDisplayTimer.attach_ms(MATRIX_DISPLAY_REFRESH_MS, setMatrixIRQ);
 #endif
 
 // initialize button
@@ -488,6 +491,9 @@ void setup() {
   // cyclic function interrupts
   cyclicTimer.attach(HOMECYCLE, setCyclicIRQ);
 
+  // clock scaling and light sleep, after all tasks and locks are set up
+  pm_init();
+
   // show compiled features
   ESP_LOGI(TAG, "Features:%s", features);
 
@@ -5,7 +5,7 @@
 static QueueHandle_t MQTTSendQueue;
 TaskHandle_t mqttTask;
 
-Ticker mqttTimer;
+JobTimer mqttTimer;
 WiFiClient netClient;
 MQTTClient mqttClient;
 
@@ -25,7 +25,7 @@ esp_err_t mqtt_init(void) {
   mqttClient.onMessageAdvanced(mqtt_callback);
 
   _ASSERT(SEND_QUEUE_SIZE > 0);
-  MQTTSendQueue = xQueueCreate(SEND_QUEUE_SIZE, sizeof(MessageBuffer_t));
+  MQTTSendQueue = QUEUE_CREATE(SEND_QUEUE_SIZE, sizeof(MessageBuffer_t));
   if (MQTTSendQueue == 0) {
     ESP_LOGE(TAG, "Could not create MQTT send queue. Aborting.");
     return ESP_FAIL;
@@ -34,11 +34,65 @@ esp_err_t mqtt_init(void) {
            SEND_QUEUE_SIZE * PAYLOAD_BUFFER_SIZE);
 
   ESP_LOGI(TAG, "Starting MQTTloop...");
-  xTaskCreatePinnedToCore(mqtt_client_task, "mqttloop", 4096, (void *)NULL, 5,
-                          &mqttTask, 1);
+  TASK_CREATE(mqtt_client_task, "mqttloop", 4096, (void *)NULL, 5, &mqttTask,
+              1);
   return ESP_OK;
 }
 
+// publish send path statistics of all transports as JSON
+static void mqtt_publishstats(void) {
+  static const char *const names[TRANSPORT_COUNT] = {"lora", "spi", "mqtt"};
+  char json[768];
+  size_t len = snprintf(json, sizeof(json), "{\"uptime\":%llu",
+                        (unsigned long long)(uptime() / 1000ULL));
+
+  for (int t = 0; t < TRANSPORT_COUNT && len < sizeof(json); t++) {
+    sendStats_t st;
+    stats_get((transport_t)t, &st);
+    len += snprintf(json + len, sizeof(json) - len,
+                    ",\"%s\":{\"sent\":%u,\"drops\":%u,\"retries\":%u,"
+                    "\"toolarge\":%u,\"queue_hwm\":%u,\"wait\":[",
+                    names[t], (unsigned)st.sent, st.drops, st.retries,
+                    st.toolarge, st.queue_hwm);
+    for (int b = 0; b < STATS_BUCKETS && len < sizeof(json); b++)
+      len += snprintf(json + len, sizeof(json) - len, "%s%u", b ? "," : "",
+                      st.wait[b]);
+    for (int b = 0; b < STATS_BUCKETS && len < sizeof(json); b++)
+      len += snprintf(json + len, sizeof(json) - len, "%s%u",
+                      b ? "," : "],\"latency\":[", st.latency[b]);
+    if (len < sizeof(json))
+      len += snprintf(json + len, sizeof(json) - len, "]}");
+  }
+  if (len < sizeof(json))
+    len += snprintf(json + len, sizeof(json) - len, "}");
+
+  if (len >= sizeof(json))
+    ESP_LOGW(TAG, "MQTT statistics truncated");
+  else if (!mqttClient.publish(MQTT_STATSTOPIC, json, len))
+    ESP_LOGD(TAG, "Couldn't sent statistics to MQTT server");
+}
+
+// publish telemetry record of tasks and heap, base64 encoded as payloads
+static void mqtt_publishtelemetry(void) {
+  telemetry_t telemetry;
+  telemetry_get(&telemetry);
+  PayloadConvert record(PAYLOAD_BUFFER_SIZE);
+  record.addTelemetry(telemetry);
+  if (!record.getSize())
+    return; // no representation in this payload format
+
+  size_t out_len = 0;
+  mbedtls_base64_encode(NULL, 0, &out_len, record.getBuffer(),
+                        record.getSize());
+  unsigned char encoded[out_len];
+  mbedtls_base64_encode(encoded, out_len, &out_len, record.getBuffer(),
+                        record.getSize());
+
+  if (!mqttClient.publish(MQTT_TELEMETRYTOPIC, (const char *)encoded,
+                          out_len))
+    ESP_LOGD(TAG, "Couldn't sent telemetry to MQTT server");
+}
+
 int mqtt_connect(const char *my_host, const uint16_t my_port) {
   IPAddress mqtt_server_ip;
 
@@ -60,6 +114,7 @@ int mqtt_connect(const char *my_host, const uint16_t my_port) {
     mqttClient.publish(MQTT_INTOPIC, "", true, 1);
     mqttClient.subscribe(MQTT_INTOPIC);
     ESP_LOGI(TAG, "MQTT topic subscribed");
+    route_setlink(TRANSPORT_MQTT, true);
   } else {
     ESP_LOGD(TAG, "MQTT last_error = %d / rc = %d", mqttClient.lastError(),
              mqttClient.returnCode());
@@ -72,12 +127,21 @@ int mqtt_connect(const char *my_host, const uint16_t my_port) {
 
 void mqtt_client_task(void *param) {
   MessageBuffer_t msg;
+  uint32_t statstime = millis();
 
   while (1) {
     if (mqttClient.connected()) {
       // check for incoming messages
       mqttClient.loop();
 
+      // publish send path statistics and telemetry
+      if (MQTT_STATSCYCLE &&
+          (millis() - statstime >= MQTT_STATSCYCLE * 1000UL)) {
+        statstime = millis();
+        mqtt_publishstats();
+        mqtt_publishtelemetry();
+      }
+
       // fetch next or wait for payload to send from queue
       // do not delete item from queue until it is transmitted
       // consider mqtt timeout while waiting
@@ -100,13 +164,18 @@ void mqtt_client_task(void *param) {
                             (unsigned char *)msg.Message, msg.MessageSize);
 
       // send encoded message to mqtt server and delete it from queue
+      uint32_t started = millis();
       if (mqttClient.publish(topic, (const char *)encoded, out_len)) {
         ESP_LOGD(TAG, "%u bytes sent to MQTT server", out_len);
         xQueueReceive(MQTTSendQueue, &msg, (TickType_t)0);
-      } else
+        stats_sent(TRANSPORT_MQTT, msg.MessageTime, started);
+      } else {
         ESP_LOGD(TAG, "Couldn't sent message to MQTT server");
+        stats_retried(TRANSPORT_MQTT, 1);
+      }
     } else {
       // attempt to reconnect to MQTT server
+      route_setlink(TRANSPORT_MQTT, false);
       ESP_LOGD(TAG, "MQTT client reconnecting...");
       delay(MQTT_RETRYSEC * 1000);
       mqtt_connect(MQTT_SERVER, MQTT_PORT);
@@ -132,8 +201,12 @@ void mqtt_callback(MQTTClient *client, char *topic, char *payload, int length) {
 
 // enqueue outgoing messages in MQTT send queue
 void mqtt_enqueuedata(MessageBuffer_t *message) {
-  if (xQueueSendToBack(MQTTSendQueue, (void *)message, (TickType_t)0) != pdTRUE)
+  if (xQueueSendToBack(MQTTSendQueue, (void *)message, (TickType_t)0) !=
+      pdTRUE) {
     ESP_LOGW(TAG, "MQTT sendqueue is full");
+    stats_dropped(TRANSPORT_MQTT);
+  } else
+    stats_enqueued(TRANSPORT_MQTT, uxQueueMessagesWaiting(MQTTSendQueue));
 }
 
 void mqtt_queuereset(void) { xQueueReset(MQTTSendQueue); }
@@ -0,0 +1,192 @@
+// Basic Config
+#include "nmea.h"
+#include <string.h>
+
+/* minimal NMEA decoder
+
+Decodes only the $--RMC and $--GGA sentences (any talker id, e.g. GP, GN, GL),
+which carry everything we use: time, date, position, altitude, satellites and
+hdop. All other sentences are dropped after their 6th character, without
+being buffered. Numbers are decoded to scaled integers, no floating point.
+*/
+
+// decimal number with fraction, scaled to given number of decimals
+static bool nmea_fixed(const char *p, const char *end, uint8_t decimals,
+                       int32_t *value) {
+  bool neg = false, digits = false;
+  int32_t v = 0;
+  uint8_t frac = 0;
+  bool dot = false;
+
+  if (p < end && *p == '-') {
+    neg = true;
+    p++;
+  }
+  for (; p < end; p++) {
+    if (*p == '.') {
+      if (dot)
+        return false;
+      dot = true;
+    } else if (*p >= '0' && *p <= '9') {
+      digits = true;
+      if (dot) {
+        if (frac >= decimals)
+          continue; // ignore excess decimals
+        frac++;
+      }
+      v = v * 10 + (*p - '0');
+    } else
+      return false;
+  }
+  for (; frac < decimals; frac++)
+    v *= 10;
+  *value = neg ? -v : v;
+  return digits;
+}
+
+// two digit decimal
+static inline uint8_t nmea_2dig(const char *p) {
+  return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+// coordinate (d)ddmm.mmmmm and hemisphere to 1e-6 degrees
+static bool nmea_coord(const char *p, const char *end, const char *h,
+                       const char *hend, int32_t *value) {
+  int32_t v; // ddmm.mmmmm scaled to 1e5
+  if (!nmea_fixed(p, end, 5, &v) || v < 0 || hend - h != 1)
+    return false;
+  int32_t deg = v / 10000000, min = v % 10000000; // minutes * 1e5
+  v = deg * 1000000 + (min + 3) / 6;              // minutes / 60 * 1e6
+  *value = (*h == 'S' || *h == 'W') ? -v : v;
+  return true;
+}
+
+static bool nmea_time(const char *p, const char *end, nmeaFix_t *fix) {
+  if (end - p < 6)
+    return false;
+  for (int i = 0; i < 6; i++)
+    if (p[i] < '0' || p[i] > '9')
+      return false;
+  fix->hour = nmea_2dig(p);
+  fix->minute = nmea_2dig(p + 2);
+  fix->second = nmea_2dig(p + 4);
+  int32_t cs = 0;
+  if (end - p > 7 && p[6] == '.')
+    nmea_fixed(p + 7, (end - p > 9) ? p + 9 : end, 0, &cs); // first two decimals
+  if (end - p == 8) // one decimal only
+    cs *= 10;
+  fix->centisecond = cs;
+  return true;
+}
+
+static inline uint8_t nmea_hex(char c) {
+  return (c >= 'A') ? (c & 0x0f) + 9 : c - '0';
+}
+
+// decode one sentence from '$' up to, not including, CR/LF
+bool nmea_parse(const char *s, size_t len, nmeaFix_t *fix, uint32_t now_ms) {
+  const char *field[15], *end = s + len;
+  uint8_t n = 0, crc = 0;
+
+  if (len < 10 || s[0] != '$' || end[-3] != '*')
+    return false;
+
+  // verify checksum, xor over all between $ and *
+  for (const char *p = s + 1; p < end - 3; p++)
+    crc ^= *p;
+  if (crc != (nmea_hex(end[-2]) << 4 | nmea_hex(end[-1])))
+    return false;
+  end -= 3;
+
+  // split fields in place, field[i] points behind its preceding comma
+  for (const char *p = s; p < end && n < 15; p++)
+    if (*p == ',')
+      field[n++] = p + 1;
+  if (n < 10)
+    return false;
+#define FIELD(i) field[i], ((i) + 1 < n ? field[(i) + 1] - 1 : end)
+
+  nmeaFix_t f = *fix; // commit all values of the sentence, or none
+
+  if (!memcmp(s + 3, "RMC", 3)) {
+    // $--RMC,time,status,lat,N,lon,E,speed,course,date,...
+    if (!nmea_time(FIELD(0), &f))
+      return false;
+    f.time_ms = now_ms;
+    const char *d = field[8];
+    if ((field[9] - 1 - d) == 6) {
+      f.day = nmea_2dig(d);
+      f.month = nmea_2dig(d + 2);
+      f.year = 2000 + nmea_2dig(d + 4);
+      f.date_ms = now_ms;
+    }
+    if (*field[1] == 'A' && nmea_coord(FIELD(2), FIELD(3), &f.latitude) &&
+        nmea_coord(FIELD(4), FIELD(5), &f.longitude))
+      f.location_ms = now_ms;
+  } else if (!memcmp(s + 3, "GGA", 3)) {
+    // $--GGA,time,lat,N,lon,E,quality,sats,hdop,alt,M,...
+    int32_t v;
+    if (!nmea_time(FIELD(0), &f))
+      return false;
+    f.time_ms = now_ms;
+    if (*field[5] > '0') { // quality 0 = no fix
+      if (nmea_coord(FIELD(1), FIELD(2), &f.latitude) &&
+          nmea_coord(FIELD(3), FIELD(4), &f.longitude))
+        f.location_ms = now_ms;
+      if (nmea_fixed(FIELD(8), 2, &v)) {
+        f.altitude = v;
+        f.altitude_ms = now_ms;
+      }
+    }
+    if (nmea_fixed(FIELD(6), 0, &v)) {
+      f.satellites = v;
+      f.satellites_ms = now_ms;
+    }
+    if (nmea_fixed(FIELD(7), 2, &v)) {
+      f.hdop = v;
+      f.hdop_ms = now_ms;
+    }
+  } else
+    return false;
+#undef FIELD
+
+  *fix = f;
+  return true;
+}
+
+// feed received characters, decodes each complete sentence of interest
+void nmea_feed(nmeaDecoder_t *dec, nmeaFix_t *fix, const char *data,
+               size_t len, uint32_t now_ms) {
+  for (const char *p = data; p < data + len; p++) {
+    char c = *p;
+    if (c == '$') {
+      dec->len = 0;
+      dec->skip = false;
+    } else if (dec->skip)
+      continue;
+
+    if (c == '\r' || c == '\n') {
+      if (dec->len) {
+        if (nmea_parse(dec->line, dec->len, fix, now_ms))
+          dec->sentences++;
+        else
+          dec->failed++;
+      }
+      dec->len = 0;
+      dec->skip = true;
+      continue;
+    }
+
+    if (dec->len >= NMEA_MAXLEN) { // overlong, garbage
+      dec->failed++;
+      dec->skip = true;
+      continue;
+    }
+    dec->line[dec->len++] = c;
+
+    // drop sentence types we don't decode, after "$--XXX"
+    if (dec->len == 6 && memcmp(dec->line + 3, "RMC", 3) &&
+        memcmp(dec->line + 3, "GGA", 3))
+      dec->skip = true;
+  }
+}
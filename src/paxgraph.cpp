@@ -0,0 +1,93 @@
+#if (defined HAS_DISPLAY || defined HAS_MATRIX_DISPLAY)
+
+// Basic Config
+#include "globals.h"
+#include "paxgraph.h"
+
+/* pax graph data
+
+Pax counts are kept as numbers in one ring buffer per zoom level: per send
+cycle, per hour and per day. Hour and day values are the maximum count of
+the send cycles in that period. The running cycle, hour and day are kept
+apart and shown as newest value of their series. Displays render from
+these series when the graph is shown, with their own scaling.
+
+Called from irqHandler task only (send cycle and display refresh), thus
+no locking.
+*/
+
+typedef struct {
+  uint16_t value[PAXGRAPH_LEN]; // values of closed periods, ring buffer
+  uint16_t head;                // index of next value to write
+  uint16_t len;                 // number of values stored
+  uint16_t current;             // value of running period
+  uint64_t start;               // uptime at start of running period [ms]
+} paxseries_t;
+
+static const uint32_t period_ms[PAXGRAPH_ZOOMS] = {0, 3600000UL, 86400000UL};
+static paxseries_t series[PAXGRAPH_ZOOMS] = {0};
+static uint32_t revision = 0;
+
+static void series_push(paxseries_t *s, uint16_t value) {
+  s->value[s->head] = value;
+  s->head = (s->head + 1) % PAXGRAPH_LEN;
+  if (s->len < PAXGRAPH_LEN)
+    s->len++;
+}
+
+// a send cycle ended with given count
+void paxgraph_add(uint16_t count) {
+  const uint64_t now = uptime();
+
+  series_push(&series[PAXGRAPH_CYCLE], count);
+  series[PAXGRAPH_CYCLE].current = 0;
+
+  for (uint8_t z = PAXGRAPH_HOUR; z < PAXGRAPH_ZOOMS; z++) {
+    paxseries_t *s = &series[z];
+    s->current = max(s->current, count);
+    if (now - s->start >= period_ms[z]) { // period ended
+      series_push(s, s->current);
+      s->current = 0;
+      s->start += (now - s->start) / period_ms[z] * period_ms[z];
+    }
+  }
+  revision++;
+}
+
+// count of running send cycle
+void paxgraph_live(uint16_t count) {
+  if (series[PAXGRAPH_CYCLE].current != count) {
+    series[PAXGRAPH_CYCLE].current = count;
+    revision++;
+  }
+}
+
+// copy up to n newest values of a zoom level, oldest first, including the
+// running period; returns number of values copied
+uint16_t paxgraph_get(uint8_t zoom, uint16_t *values, uint16_t n) {
+  const paxseries_t *s = &series[zoom];
+
+  if (!n)
+    return 0;
+
+  uint16_t stored = min((uint16_t)(n - 1), s->len);
+  uint16_t idx = (s->head + PAXGRAPH_LEN - stored) % PAXGRAPH_LEN;
+  for (uint16_t i = 0; i < stored; i++) {
+    values[i] = s->value[idx];
+    idx = (idx + 1) % PAXGRAPH_LEN;
+  }
+  values[stored] = max(s->current, series[PAXGRAPH_CYCLE].current);
+  return stored + 1;
+}
+
+uint16_t paxgraph_max(const uint16_t *values, uint16_t n) {
+  uint16_t m = 0;
+  for (uint16_t i = 0; i < n; i++)
+    m = max(m, values[i]);
+  return m;
+}
+
+// changes whenever graph data changed
+uint32_t paxgraph_revision(void) { return revision; }
+
+#endif // HAS_DISPLAY || HAS_MATRIX_DISPLAY
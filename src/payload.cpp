@@ -17,6 +17,16 @@ uint8_t PayloadConvert::getSize(void) { return cursor; }
 
 uint8_t *PayloadConvert::getBuffer(void) { return buffer; }
 
+// memory sizes in telemetry are sent in units of 16 bytes, saturated
+static inline uint32_t units16(uint32_t bytes, uint32_t limit) {
+  return (bytes >> 4) > limit ? limit : bytes >> 4;
+}
+
+static inline int16_t trend16(int32_t bytes) {
+  bytes /= 16;
+  return bytes > INT16_MAX ? INT16_MAX : bytes < INT16_MIN ? INT16_MIN : bytes;
+}
+
 /* ---------------- plain format without special encoding ---------- */
 
 #if (PAYLOAD_ENCODER == 1)
@@ -150,6 +160,67 @@ void PayloadConvert::addTime(time_t value) {
   buffer[cursor++] = (byte)((time & 0x000000FF));
 }
 
+void PayloadConvert::addSendStats(uint8_t page, sendStats_t value) {
+  buffer[cursor++] = page;
+  buffer[cursor++] = (byte)((value.sent & 0xFF000000) >> 24);
+  buffer[cursor++] = (byte)((value.sent & 0x00FF0000) >> 16);
+  buffer[cursor++] = (byte)((value.sent & 0x0000FF00) >> 8);
+  buffer[cursor++] = (byte)((value.sent & 0x000000FF));
+  buffer[cursor++] = highByte(value.drops);
+  buffer[cursor++] = lowByte(value.drops);
+  buffer[cursor++] = highByte(value.retries);
+  buffer[cursor++] = lowByte(value.retries);
+  buffer[cursor++] = highByte(value.toolarge);
+  buffer[cursor++] = lowByte(value.toolarge);
+  buffer[cursor++] = value.queue_hwm;
+  for (int i = 0; i < STATS_BUCKETS; i++) {
+    buffer[cursor++] = highByte(value.wait[i]);
+    buffer[cursor++] = lowByte(value.wait[i]);
+  }
+  for (int i = 0; i < STATS_BUCKETS; i++) {
+    buffer[cursor++] = highByte(value.latency[i]);
+    buffer[cursor++] = lowByte(value.latency[i]);
+  }
+}
+
+void PayloadConvert::addSleepClock(uint8_t page, sleepClock_t value) {
+  buffer[cursor++] = page;
+  buffer[cursor++] = (byte)((value.ppm & 0xFF000000) >> 24);
+  buffer[cursor++] = (byte)((value.ppm & 0x00FF0000) >> 16);
+  buffer[cursor++] = (byte)((value.ppm & 0x0000FF00) >> 8);
+  buffer[cursor++] = (byte)((value.ppm & 0x000000FF));
+  buffer[cursor++] = highByte(value.samples);
+  buffer[cursor++] = lowByte(value.samples);
+  buffer[cursor++] = (byte)((value.slept & 0xFF000000) >> 24);
+  buffer[cursor++] = (byte)((value.slept & 0x00FF0000) >> 16);
+  buffer[cursor++] = (byte)((value.slept & 0x0000FF00) >> 8);
+  buffer[cursor++] = (byte)((value.slept & 0x000000FF));
+  buffer[cursor++] = (byte)((value.residual & 0xFF000000) >> 24);
+  buffer[cursor++] = (byte)((value.residual & 0x00FF0000) >> 16);
+  buffer[cursor++] = (byte)((value.residual & 0x0000FF00) >> 8);
+  buffer[cursor++] = (byte)((value.residual & 0x000000FF));
+}
+
+void PayloadConvert::addTelemetry(telemetry_t value) {
+  uint16_t heap_min = units16(value.heap_min, UINT16_MAX);
+  uint16_t heap_block = units16(value.heap_block, UINT16_MAX);
+  buffer[cursor++] = highByte(heap_min);
+  buffer[cursor++] = lowByte(heap_min);
+  buffer[cursor++] = highByte(heap_block);
+  buffer[cursor++] = lowByte(heap_block);
+  int16_t heap_trend = trend16(value.heap_trend);
+  int16_t block_trend = trend16(value.block_trend);
+  buffer[cursor++] = highByte(heap_trend);
+  buffer[cursor++] = lowByte(heap_trend);
+  buffer[cursor++] = highByte(block_trend);
+  buffer[cursor++] = lowByte(block_trend);
+  for (int i = 0; i < value.tasks; i++) {
+    buffer[cursor++] = value.task[i].id;
+    buffer[cursor++] = value.task[i].cpu;
+    buffer[cursor++] = units16(value.task[i].stack, UINT8_MAX);
+  }
+}
+
 /* ---------------- packed format with LoRa serialization Encoder ----------
  */
 // derived from
@@ -238,6 +309,39 @@ void PayloadConvert::addTime(time_t value) {
   writeUint32(time);
 }
 
+void PayloadConvert::addSendStats(uint8_t page, sendStats_t value) {
+  writeUint8(page);
+  writeUint32(value.sent);
+  writeUint16(value.drops);
+  writeUint16(value.retries);
+  writeUint16(value.toolarge);
+  writeUint8(value.queue_hwm);
+  for (int i = 0; i < STATS_BUCKETS; i++)
+    writeUint16(value.wait[i]);
+  for (int i = 0; i < STATS_BUCKETS; i++)
+    writeUint16(value.latency[i]);
+}
+
+void PayloadConvert::addSleepClock(uint8_t page, sleepClock_t value) {
+  writeUint8(page);
+  writeUint32((uint32_t)value.ppm);
+  writeUint16(value.samples);
+  writeUint32(value.slept);
+  writeUint32((uint32_t)value.residual);
+}
+
+void PayloadConvert::addTelemetry(telemetry_t value) {
+  writeUint16(units16(value.heap_min, UINT16_MAX));
+  writeUint16(units16(value.heap_block, UINT16_MAX));
+  writeUint16(trend16(value.heap_trend));
+  writeUint16(trend16(value.block_trend));
+  for (int i = 0; i < value.tasks; i++) {
+    writeUint8(value.task[i].id);
+    writeUint8(value.task[i].cpu);
+    writeUint8(units16(value.task[i].stack, UINT8_MAX));
+  }
+}
+
 void PayloadConvert::uintToBytes(uint64_t value, uint8_t byteSize) {
   for (uint8_t x = 0; x < byteSize; x++) {
     byte next = 0;
@@ -500,6 +604,14 @@ void PayloadConvert::addTime(time_t value) {
   buffer[cursor++] = (byte)((tx_period & 0x000000FF));
 #endif
 }
+
+// send statistics have no Cayenne LPP representation
+void PayloadConvert::addSendStats(uint8_t page, sendStats_t value) {}
+
+void PayloadConvert::addSleepClock(uint8_t page, sleepClock_t value) {}
+
+void PayloadConvert::addTelemetry(telemetry_t value) {}
+
 #endif // PAYLOAD_ENCODER
 
 void PayloadConvert::addChars(char *string, int len) {
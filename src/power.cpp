@@ -285,6 +285,83 @@ void PMU_init(void) {
 
 #endif // HAS_PMU
 
+#if (POWER_MANAGEMENT) && (CONFIG_PM_ENABLE)
+
+static esp_pm_lock_handle_t pm_lock[PM_LOCKS];
+static bool pm_held[PM_LOCKS];
+static portMUX_TYPE pm_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void pm_init(void) {
+  static const char *const names[PM_LOCKS] = {"radio", "display", "periph"};
+#if CONFIG_IDF_TARGET_ESP32S3
+  esp_pm_config_esp32s3_t config;
+#else
+  esp_pm_config_esp32_t config;
+#endif
+  config.max_freq_mhz = getCpuFrequencyMhz();
+  config.min_freq_mhz = PM_MIN_FREQ;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  config.light_sleep_enable = true;
+#else
+  config.light_sleep_enable = false;
+  ESP_LOGW(TAG, "Tickless idle disabled in sdkconfig, no light sleep");
+#endif
+
+  // locks may already have been requested by tasks started before
+  for (int i = 0; i < PM_LOCKS; i++) {
+    esp_pm_lock_handle_t handle = NULL;
+    esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, names[i], &handle);
+    portENTER_CRITICAL(&pm_mux);
+    pm_lock[i] = handle;
+    bool held = pm_held[i];
+    portEXIT_CRITICAL(&pm_mux);
+    if (held && handle)
+      esp_pm_lock_acquire(handle);
+  }
+
+  // these are served by UART, hardware timers or edge interrupts, which stop
+  // in light sleep
+#if (HAS_GPS) || defined HAS_MATRIX_DISPLAY || defined HAS_DCF77 ||           \
+    defined HAS_IF482 || defined HAS_SPI || defined HAS_MQTT ||                \
+    defined PMU_INT
+  pm_hold(PM_PERIPH, true);
+#endif
+
+  if (esp_pm_configure(&config) == ESP_OK)
+    ESP_LOGI(TAG, "Power management on, cpu %d..%d MHz, light sleep %s",
+             config.min_freq_mhz, config.max_freq_mhz,
+             config.light_sleep_enable ? "on" : "off");
+  else
+    ESP_LOGE(TAG, "Power management configuration failed");
+}
+
+// hold or release a lock, repeated calls with same state are ignored
+void pm_hold(pmLock_t lock, bool hold) {
+  portENTER_CRITICAL(&pm_mux);
+  bool change = pm_held[lock] != hold;
+  pm_held[lock] = hold;
+  esp_pm_lock_handle_t handle = pm_lock[lock];
+  portEXIT_CRITICAL(&pm_mux);
+  if (!change || !handle)
+    return;
+  if (hold)
+    esp_pm_lock_acquire(handle);
+  else
+    esp_pm_lock_release(handle);
+}
+
+#else
+
+void pm_init(void) {
+#if (POWER_MANAGEMENT)
+  ESP_LOGW(TAG, "Power management not enabled in sdkconfig");
+#endif
+}
+
+void pm_hold(pmLock_t lock, bool hold) {}
+
+#endif // POWER_MANAGEMENT
+
 void calibrate_voltage(void) {
 #ifdef BAT_MEASURE_ADC
 // configure ADC
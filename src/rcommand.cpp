@@ -1,6 +1,7 @@
 // Basic Config
 #include "globals.h"
 #include "rcommand.h"
+#include "timefusion.h"
 
 static QueueHandle_t RcmdQueue;
 TaskHandle_t rcmdTask;
@@ -19,6 +20,9 @@ void set_reset(uint8_t val[]) {
     ESP_LOGI(TAG,
              "Remote command: reset device to factory settings and restart");
     eraseConfig();
+#if (HAS_LORA) && (LORA_SESSION_PERSIST) && !defined(LORA_ABP)
+    lora_session_erase();
+#endif
     do_reset(false);
     break;
   case 3: // reset send queues
@@ -219,6 +223,22 @@ void set_sensor(uint8_t val[]) {
 #endif
 }
 
+void set_portroute(uint8_t val[]) {
+  if (val[0] >= ROUTE_PORTS) {
+    ESP_LOGW(TAG, "Remote command: set port route called with invalid port %u",
+             val[0]);
+    return;
+  }
+  cfg.portroute[val[0]].transports = val[1] & ROUTE_ALL;
+  cfg.portroute[val[0]].fallback = val[2] & ROUTE_ALL;
+  cfg.portroute[val[0]].failover = val[3];
+  ESP_LOGI(TAG,
+           "Remote command: set route for port %u to transports 0x%02X, "
+           "fallback 0x%02X after %u min",
+           val[0], cfg.portroute[val[0]].transports,
+           cfg.portroute[val[0]].fallback, val[3]);
+}
+
 uint64_t macConvert(uint8_t *paddr) {
   uint64_t *mac;
   mac = (uint64_t *)paddr;
@@ -231,6 +251,9 @@ void set_loradr(uint8_t val[]) {
     cfg.loradr = val[0];
     ESP_LOGI(TAG, "Remote command: set LoRa Datarate to %u", cfg.loradr);
     LMIC_setDrTxpow(assertDR(cfg.loradr), KEEP_TXPOW);
+#if (LORA_LINKADAPT)
+    linkadapt_reset();
+#endif
     ESP_LOGI(TAG, "Radio parameters now %s / %s / %s",
              getSfName(updr2rps(LMIC.datarate)),
              getBwName(updr2rps(LMIC.datarate)),
@@ -333,6 +356,38 @@ void get_status(uint8_t val[]) {
   SendPayload(STATUSPORT);
 }
 
+// extended device status, pages 0..2 = send statistics of LORA, SPI, MQTT,
+// page 3 = deep sleep clock
+void get_statusext(uint8_t val[]) {
+  ESP_LOGI(TAG, "Remote command: get extended device status page %d", val[0]);
+  payload.reset();
+  if (val[0] < TRANSPORT_COUNT) {
+    sendStats_t stats;
+    stats_get((transport_t)val[0], &stats);
+    payload.addSendStats(val[0], stats);
+  } else if (val[0] == 3) {
+    sleepClock_t sleepclock;
+    sleep_clock(&sleepclock);
+    payload.addSleepClock(val[0], sleepclock);
+  } else {
+    ESP_LOGW(TAG, "Remote command: status page %d not supported", val[0]);
+    return;
+  }
+  SendPayload(STATUSPORT);
+}
+
+void get_telemetry(uint8_t val[]) {
+  ESP_LOGI(TAG, "Remote command: get task telemetry");
+  telemetry_t telemetry;
+  telemetry_get(&telemetry);
+  payload.reset();
+  payload.addTelemetry(telemetry);
+  if (payload.getSize())
+    SendPayload(TELEMETRYPORT);
+  else
+    ESP_LOGW(TAG, "Telemetry not supported by payload format");
+}
+
 void get_gps(uint8_t val[]) {
   ESP_LOGI(TAG, "Remote command: get gps status");
 #if (HAS_GPS)
@@ -387,6 +442,7 @@ void set_time(uint8_t val[]) {
   uint32_t t = __builtin_bswap32(*(uint32_t *)(val));
   ESP_LOGI(TAG, "Remote command: set time to %lu", t);
   setMyTime(t, 0, _set);
+  time_forget();
 }
 
 void set_flush(uint8_t val[]) {
@@ -421,11 +477,13 @@ static const cmd_t table[] = {
     {0x14, set_payloadmask, 1},   {0x15, set_bme, 1},
     {0x16, set_batt, 1},          {0x17, set_wifiscan, 1},
     {0x18, set_flush, 0},         {0x19, set_sleepcycle, 2},
+    {0x1a, set_portroute, 4},
     {0x20, set_loadconfig, 0},    {0x21, set_saveconfig, 0},
     {0x80, get_config, 0},        {0x81, get_status, 0},
     {0x83, get_batt, 0},          {0x84, get_gps, 0},
     {0x85, get_bme, 0},           {0x86, get_time, 0},
     {0x87, set_timesync, 0},      {0x88, set_time, 4},
+    {0x89, get_statusext, 1},     {0x8a, get_telemetry, 0},
     {0x99, set_flush, 0}};
 
 static const uint8_t cmdtablesize =
@@ -486,6 +544,12 @@ void rcmd_process(void *pvParameters) {
 // enqueue remote command
 void rcommand(const uint8_t *cmd, const size_t cmdlength) {
   RcmdBuffer_t rcmd = {0};
+
+  if (cmdlength > sizeof(rcmd.cmd)) {
+    ESP_LOGW(TAG, "Remote command too long, ignored");
+    return;
+  }
+
   rcmd.cmdLen = cmdlength;
   memcpy(rcmd.cmd, cmd, cmdlength);
 
@@ -504,7 +568,7 @@ void rcmd_deinit(void) {
 
 esp_err_t rcmd_init(void) {
   _ASSERT(RCMD_QUEUE_SIZE > 0);
-  RcmdQueue = xQueueCreate(RCMD_QUEUE_SIZE, sizeof(RcmdBuffer_t));
+  RcmdQueue = QUEUE_CREATE(RCMD_QUEUE_SIZE, sizeof(RcmdBuffer_t));
   if (RcmdQueue == 0) {
     ESP_LOGE(TAG, "Could not create rcommand send queue. Aborting.");
     return ESP_FAIL;
@@ -512,13 +576,13 @@ esp_err_t rcmd_init(void) {
   ESP_LOGI(TAG, "Rcommand send queue created, size %u Bytes",
            RCMD_QUEUE_SIZE * sizeof(RcmdBuffer_t));
 
-  xTaskCreatePinnedToCore(rcmd_process, // task function
-                          "rcmdloop",   // name of task
-                          3072,         // stack size of task
-                          (void *)1,    // parameter of the task
-                          1,            // priority of the task
-                          &rcmdTask,    // task handle
-                          1);           // CPU core
+  TASK_CREATE(rcmd_process, // task function
+              "rcmdloop",   // name of task
+              3072,         // stack size of task
+              (void *)1,    // parameter of the task
+              1,            // priority of the task
+              &rcmdTask,    // task handle
+              1);           // CPU core
 
   return ESP_OK;
 } // rcmd_init()
\ No newline at end of file
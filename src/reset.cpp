@@ -1,6 +1,7 @@
 // Basic Config
 #include "globals.h"
 #include "reset.h"
+#include "timefusion.h"
 
 // Conversion factor for micro seconds to seconds
 #define uS_TO_S_FACTOR 1000000ULL
@@ -11,6 +12,10 @@ RTC_NOINIT_ATTR uint32_t RTC_restarts;
 // RTC_DATA_ATTR -> keeps value after a wakeup from sleep
 RTC_DATA_ATTR struct timeval sleep_start_time;
 RTC_DATA_ATTR int64_t RTC_millis = 0;
+// learned error of RTC slow clock in deep sleep, see sleep_learn()
+RTC_DATA_ATTR sleepClock_t RTC_sleepclock = {0};
+RTC_DATA_ATTR bool sleep_synced = false; // time was synced when going asleep
+RTC_DATA_ATTR int64_t sleep_true_ms = 0; // corrected duration of last sleep
 
 struct timeval sleep_stop_time;
 
@@ -19,10 +24,62 @@ void reset_rtc_vars(void) {
   RTC_restarts = 0;
 }
 
+// convert a duration measured by sleep clock to true time, and vice versa
+static int64_t sleep_to_true(int64_t ms) {
+  return ms * 1000000LL / (1000000LL + RTC_sleepclock.ppm);
+}
+
+static int64_t true_to_sleep(int64_t ms) {
+  return ms * (1000000LL + RTC_sleepclock.ppm) / 1000000LL;
+}
+
+// learn sleep clock error from the first precise time sync after a wakeup.
+// offset_ms is reference time minus system time, which was corrected by the
+// current estimate on wakeup, thus it is the residual error of the estimate.
+void sleep_learn(int64_t offset_ms, timesource_t source) {
+  if (!sleep_synced || ((source != _gps) && (source != _lora)))
+    return;
+  sleep_synced = false; // learn once per wakeup
+
+  if (sleep_true_ms < SLEEP_LEARN_MIN * 1000LL)
+    return;
+
+  // clock measured sleep -offset_ms longer than it was
+  int32_t ppm = RTC_sleepclock.ppm - offset_ms * 1000000LL / sleep_true_ms;
+  if (abs(ppm) > SLEEP_PPM_LIMIT) {
+    ESP_LOGW(TAG, "Sleep clock error %d ppm implausible, ignored", ppm);
+    return;
+  }
+
+  // error of the estimate this sleep was corrected with
+  RTC_sleepclock.spread = llabs(offset_ms) * 1000000LL / sleep_true_ms;
+
+  // first sample is taken as is, then smooth by exponential average
+  if (RTC_sleepclock.samples == 0)
+    RTC_sleepclock.ppm = ppm;
+  else
+    RTC_sleepclock.ppm += (ppm - RTC_sleepclock.ppm) / 4;
+  if (RTC_sleepclock.samples < UINT16_MAX)
+    RTC_sleepclock.samples++;
+  RTC_sleepclock.residual = offset_ms;
+
+  ESP_LOGI(TAG, "Sleep clock: %d ms off after %u sec, error now %d ppm",
+           (int32_t)offset_ms, RTC_sleepclock.slept, RTC_sleepclock.ppm);
+}
+
+void sleep_clock(sleepClock_t *value) { *value = RTC_sleepclock; }
+
+// error of time measured by sleep clock, after correction [ppm]
+static uint32_t sleep_drift(void) {
+  if (RTC_sleepclock.samples == 0)
+    return SLEEP_DRIFT_UNLEARNED;
+  return max(RTC_sleepclock.spread, (uint32_t)SLEEP_DRIFT_FLOOR);
+}
+
 #if (HAS_TIME)
 void adjust_wakeup(uint32_t *wakeuptime) {
   // only adjust wakeup if we have a valid time
-  if ((timeSource == _unsynced) ||
+  if (!time_accurate(TIME_WAKEUP_ACCURACY) ||
       (sntp_get_sync_status() == SNTP_SYNC_STATUS_IN_PROGRESS)) {
     ESP_LOGI(TAG, "Syncwakeup: No valid time for sync");
     return;
@@ -71,6 +128,7 @@ void do_after_reset(void) {
 #ifdef TIME_SYNC_TIMEZONE
   setenv("TZ", TIME_SYNC_TIMEZONE, 1);
   tzset();
+  cal_settz(TIME_SYNC_TIMEZONE);
   ESP_LOGD(TAG, "Timezone set to %s", TIME_SYNC_TIMEZONE);
 #endif
 
@@ -93,10 +151,24 @@ void do_after_reset(void) {
                      (int64_t)sleep_start_time.tv_sec * 1000000L -
                      (int64_t)sleep_start_time.tv_usec) /
                     1000LL;
-    RTC_millis += sleep_time_ms; // increment system monotonic time
-    ESP_LOGI(TAG, "Time spent in deep sleep: %llu ms", sleep_time_ms);
+    // correct time spent in deep sleep by learned sleep clock error
+    sleep_true_ms = sleep_to_true(sleep_time_ms);
+    if (sleep_true_ms != sleep_time_ms) {
+      int64_t now_us = (int64_t)sleep_stop_time.tv_sec * 1000000LL +
+                       sleep_stop_time.tv_usec +
+                       (sleep_true_ms - sleep_time_ms) * 1000LL;
+      sleep_stop_time.tv_sec = now_us / 1000000LL;
+      sleep_stop_time.tv_usec = now_us % 1000000LL;
+      settimeofday(&sleep_stop_time, NULL);
+    }
+    RTC_sleepclock.slept = sleep_true_ms / 1000LL;
+    RTC_millis += sleep_true_ms; // increment system monotonic time
+    ESP_LOGI(TAG, "Time spent in deep sleep: %lld ms (%lld ms by sleep clock)",
+             sleep_true_ms, sleep_time_ms);
     // do we have a valid time? -> set global variable
     timeSource = timeIsValid(sleep_stop_time.tv_sec) ? _set : _unsynced;
+    if (timeSource == _set)
+      time_wakeup(sleep_true_ms, sleep_drift());
     // set wakeup state, not if we have pending OTA update
     if (RTC_runmode == RUNMODE_SLEEP)
       RTC_runmode = RUNMODE_WAKEUP;
@@ -179,9 +251,10 @@ void enter_deepsleep(uint32_t wakeup_sec, gpio_num_t wakeup_gpio) {
   // configure wakeup sources
   // https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/sleep_modes.html
 
-  // set up RTC wakeup timer, if we have
+  // set up RTC wakeup timer, if we have, compensating sleep clock error
   if (wakeup_sec > 0) {
-    esp_sleep_enable_timer_wakeup(wakeup_sec * uS_TO_S_FACTOR);
+    esp_sleep_enable_timer_wakeup(true_to_sleep(wakeup_sec * 1000LL) *
+                                  1000ULL);
   }
 
   // set wakeup gpio, if we have
@@ -196,6 +269,8 @@ void enter_deepsleep(uint32_t wakeup_sec, gpio_num_t wakeup_gpio) {
 
   // time stamp sleep start time and save system monotonic time. Deep sleep.
   gettimeofday(&sleep_start_time, NULL);
+  sleep_synced = (timeSource == _gps) || (timeSource == _lora);
+  time_sleep();
   RTC_millis += esp_timer_get_time() / 1000LL;
   ESP_LOGI(TAG, "Going to sleep, good bye.");
 
@@ -1,9 +1,12 @@
 #ifdef HAS_RTC // we have hardware RTC
 
 #include "rtctime.h"
+#include "timefusion.h"
 
 RtcDS3231<TwoWire> Rtc(Wire); // RTC hardware i2c interface
 
+static int64_t rtc_synced = -1; // uptime of last RTC setting [ms]
+
 // initialize RTC
 uint8_t rtc_init(void) {
   Wire.begin(HAS_RTC);
@@ -25,8 +28,8 @@ uint8_t rtc_init(void) {
 
   if (!Rtc.IsDateTimeValid() || !timeIsValid(t)) {
     ESP_LOGW(TAG, "RTC has no recent time, setting to compiletime");
-    Rtc.SetDateTime(RtcDateTime(mkgmtime(compileTime()) -
-                                SECS_YR_2000)); // epoch -> sec2000
+    Rtc.SetDateTime(
+        RtcDateTime(compileTime() - SECS_YR_2000)); // epoch -> sec2000
   }
 #endif
 
@@ -43,10 +46,32 @@ uint8_t set_rtctime(time_t t) { // t is sec epoch time
   Rtc.SetSquareWavePin(DS3231SquareWavePin_ModeClock); // start
 #endif
   Rtc.SetDateTime(RtcDateTime(t - SECS_YR_2000)); // epoch -> sec2000
+  rtc_synced = esp_timer_get_time() / 1000LL;
   ESP_LOGI(TAG, "RTC time synced");
   return 1; // success
 } // set_rtctime()
 
+// set RTC to system time on top of next second
+void sync_rtctime(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  vTaskDelay(pdMS_TO_TICKS(1000 - tv.tv_usec / 1000));
+  set_rtctime(tv.tv_sec + 1);
+} // sync_rtctime()
+
+// error bound of RTC time [ms], growing by drift since it was set
+uint32_t get_rtcerror(void) {
+#ifdef RTC_INT
+  uint32_t error = TIME_ERROR_RTC_PULSE;
+#else
+  uint32_t error = TIME_ERROR_RTC;
+#endif
+  // we don't know when RTC was set before restart, assume a week ago
+  int64_t age = (rtc_synced < 0) ? 7 * 86400000LL
+                                 : esp_timer_get_time() / 1000LL - rtc_synced;
+  return error + (uint32_t)(age * TIME_DRIFT_RTC / 1000000LL);
+} // get_rtcerror()
+
 time_t get_rtctime(uint16_t *msec) {
   time_t t = 0;
   *msec = 0;
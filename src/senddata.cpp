@@ -7,14 +7,89 @@
 
 // void setSendIRQ(void) { setSendIRQ(NULL); }
 
-void setSendIRQ(void) { xTaskNotify(irqHandlerTask, SENDCYCLE_IRQ, eSetBits); }
+static uint32_t sendcycle_last = 0; // [ms] start of current send cycle
 
-// put data to send in RTos Queues used for transmit over channels Lora and SPI
+void setSendIRQ(void) {
+  sendcycle_last = millis();
+  xTaskNotify(irqHandlerTask, SENDCYCLE_IRQ, eSetBits);
+}
+
+// transports compiled into this device
+static const uint8_t route_available = 0
+#if (HAS_LORA)
+                                       | ROUTE_LORA
+#endif
+#ifdef HAS_SPI
+                                       | ROUTE_SPI
+#endif
+#ifdef HAS_MQTT
+                                       | ROUTE_MQTT
+#endif
+    ;
+
+// link state of transports, SPI has no link state and is always up
+static const char *const route_names[TRANSPORT_COUNT] = {"LORA", "SPI", "MQTT"};
+static bool route_linkup[TRANSPORT_COUNT] = {false, true, false};
+static uint32_t route_downsince[TRANSPORT_COUNT] = {0}; // [ms], 0 = boot
+
+// transports report changes of their link state here
+void route_setlink(transport_t transport, bool up) {
+  if (route_linkup[transport] == up)
+    return;
+  route_linkup[transport] = up;
+  route_downsince[transport] = millis();
+  ESP_LOGI(TAG, "Transport %s is %s", route_names[transport],
+           up ? "up" : "down");
+}
+
+// transport is considered failed if it is down for longer than failover time
+static bool route_failed(int transport, uint8_t failover) {
+  return (failover && !route_linkup[transport] &&
+          (millis() - route_downsince[transport] >= failover * 60000UL));
+}
+
+// get transports for payload on a port, applying the port's routing rule
+static uint8_t route_transports(uint8_t port) {
+  if (port >= ROUTE_PORTS)
+    return route_available;
+
+  const portRoute_t *route = &cfg.portroute[port];
+  uint8_t transports = 0;
+
+  // use all primary transports of the port which did not fail
+  for (int i = 0; i < TRANSPORT_COUNT; i++)
+    if ((route->transports & route_available & _bit(i)) &&
+        !route_failed(i, route->failover))
+      transports |= _bit(i);
+
+  // no primary transport left -> use fallback transports
+  if (!transports) {
+    transports = route->fallback & route_available;
+    if (transports)
+      ESP_LOGD(TAG, "Port %d using fallback route 0x%02X", port, transports);
+  }
+
+  return transports;
+}
+
+// check if count data of the next send cycle will go out on a transport
+// within the given time
+bool sendcycle_due(transport_t transport, uint32_t within_ms) {
+  uint32_t elapsed = millis() - sendcycle_last;
+  uint32_t cycle = cfg.sendcycle * 2000UL;
+  return (cfg.payloadmask & COUNT_DATA) &&
+         (route_transports(COUNTERPORT) & _bit(transport)) &&
+         (elapsed >= cycle || cycle - elapsed <= within_ms);
+}
+
+// put data to send in RTos Queues used for transmit over channels Lora, SPI
+// and MQTT, according to the routing rule of the port
 void SendPayload(uint8_t port) {
   ESP_LOGD(TAG, "sending Payload for Port %d", port);
 
   MessageBuffer_t SendBuffer; // contains MessageSize, MessagePort, Message[]
 
+  SendBuffer.MessageTime = millis();
   SendBuffer.MessageSize = payload.getSize();
 
   switch (PAYLOAD_ENCODER) {
@@ -44,18 +119,43 @@ void SendPayload(uint8_t port) {
   }
   memcpy(SendBuffer.Message, payload.getBuffer(), SendBuffer.MessageSize);
 
+  // route message by it's original port
+  const uint8_t transports = route_transports(port);
+  if (!transports) {
+    ESP_LOGW(TAG, "No route for payload on port %d, message dropped", port);
+    return;
+  }
+
 // enqueue message in device's send queues
 #if (HAS_LORA)
-  lora_enqueuedata(&SendBuffer);
+  if (transports & ROUTE_LORA)
+    lora_enqueuedata(&SendBuffer);
 #endif
 #ifdef HAS_SPI
-  spi_enqueuedata(&SendBuffer);
+  if (transports & ROUTE_SPI)
+    spi_enqueuedata(&SendBuffer);
 #endif
 #ifdef HAS_MQTT
-  mqtt_enqueuedata(&SendBuffer);
+  if (transports & ROUTE_MQTT)
+    mqtt_enqueuedata(&SendBuffer);
 #endif
 } // SendPayload
 
+#if (HAS_GPS)
+// take GPS position, true if it shall be sent
+static bool gps_sample(gpsStatus_t *gps_status) {
+  // send GPS position only if we have a fix
+  if (!gps_hasfix()) {
+    ESP_LOGD(TAG, "No valid GPS position");
+    return false;
+  }
+  bool send = gps_storelocation(gps_status) && gps_moved(gps_status);
+  // next position is needed in next send cycle
+  gps_standby(cfg.sendcycle * 2000UL);
+  return send;
+}
+#endif
+
 // timer triggered function to prepare payload to send
 void sendData() {
   uint8_t bitmask = cfg.payloadmask;
@@ -85,13 +185,8 @@ void sendData() {
 
 #if (HAS_GPS)
       if (GPSPORT == COUNTERPORT) {
-        // send GPS position only if we have a fix
-        if (gps_hasfix()) {
-          if (gps_storelocation(&gps_status)) {
-            payload.addGPS(gps_status);
-          }
-        } else
-          ESP_LOGD(TAG, "No valid GPS position");
+        if (gps_sample(&gps_status))
+          payload.addGPS(gps_status);
       }
 #endif
 
@@ -106,8 +201,8 @@ void sendData() {
       payload.addSDS(sds_status);
 #endif
 
-#ifdef HAS_DISPLAY
-      dp_plotCurve(count.pax, true);
+#if (defined HAS_DISPLAY || defined HAS_MATRIX_DISPLAY)
+      paxgraph_add(count.pax);
 #endif
 
 #if (HAS_SDCARD)
@@ -133,15 +228,11 @@ void sendData() {
 #if (HAS_GPS)
     case GPS_DATA:
       if (GPSPORT != COUNTERPORT) {
-        // send GPS position only if we have a fix
-        if (gps_hasfix()) {
-          if (gps_storelocation(&gps_status)) {
-            payload.reset();
-            payload.addGPS(gps_status);
-            SendPayload(GPSPORT);
-          }
-        } else
-          ESP_LOGD(TAG, "No valid GPS position");
+        if (gps_sample(&gps_status)) {
+          payload.reset();
+          payload.addGPS(gps_status);
+          SendPayload(GPSPORT);
+        }
       }
       break;
 #endif
@@ -0,0 +1,63 @@
+// Basic Config
+#include "sendstats.h"
+
+// counters are updated by the send tasks of all transports
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static sendStats_t stats[TRANSPORT_COUNT];
+
+static inline void inc16(uint16_t *counter, uint16_t n = 1) {
+  *counter = (*counter > UINT16_MAX - n) ? UINT16_MAX : *counter + n;
+}
+
+// map a time in milliseconds to its histogram bucket
+static uint8_t stats_bucket(uint32_t ms) {
+  uint8_t b = 0;
+  for (ms /= STATS_BUCKET_MS; ms && b < STATS_BUCKETS - 1; ms >>= 2)
+    b++;
+  return b;
+}
+
+// message was put in send queue, depth is the queue length after enqueue
+void stats_enqueued(transport_t transport, uint32_t depth) {
+  portENTER_CRITICAL(&stats_mux);
+  if (depth > stats[transport].queue_hwm)
+    stats[transport].queue_hwm = depth > UINT8_MAX ? UINT8_MAX : depth;
+  portEXIT_CRITICAL(&stats_mux);
+}
+
+void stats_dropped(transport_t transport) {
+  portENTER_CRITICAL(&stats_mux);
+  inc16(&stats[transport].drops);
+  portEXIT_CRITICAL(&stats_mux);
+}
+
+void stats_retried(transport_t transport, uint16_t count) {
+  portENTER_CRITICAL(&stats_mux);
+  inc16(&stats[transport].retries, count);
+  portEXIT_CRITICAL(&stats_mux);
+}
+
+void stats_toolarge(transport_t transport) {
+  portENTER_CRITICAL(&stats_mux);
+  inc16(&stats[transport].toolarge);
+  portEXIT_CRITICAL(&stats_mux);
+}
+
+// message was transmitted, enqueued and started are millis() timestamps of
+// enqueue and start of transmit
+void stats_sent(transport_t transport, uint32_t enqueued, uint32_t started) {
+  uint8_t wait = stats_bucket(started - enqueued);
+  uint8_t latency = stats_bucket(millis() - started);
+  portENTER_CRITICAL(&stats_mux);
+  stats[transport].sent++;
+  inc16(&stats[transport].wait[wait]);
+  inc16(&stats[transport].latency[latency]);
+  portEXIT_CRITICAL(&stats_mux);
+}
+
+// get a consistent copy of a transport's statistics
+void stats_get(transport_t transport, sendStats_t *copy) {
+  portENTER_CRITICAL(&stats_mux);
+  *copy = stats[transport];
+  portEXIT_CRITICAL(&stats_mux);
+}
@@ -31,6 +31,301 @@ licenses. Refer to LICENSE.txt file in repository for more details.
 #include <rom/crc.h>
 
 #define HEADER_SIZE 4
+
+static QueueHandle_t SPISendQueue;
+
+TaskHandle_t spiTask;
+
+#if (SPI_PROTOCOL == 2)
+
+/* SPI protocol v2
+
+One transaction carries as many queued messages as fit in the transaction
+buffer. The master always clocks SPI_V2_BUFFER_SIZE bytes.
+
+transaction header slave -> master [6 bytes]:
+  byte 0..1 = crc16 checksum over bytes 2..5 (LSB)
+  byte 2 = protocol version (2)
+  byte 3 = number of messages in this transaction
+  byte 4 = flags, 0x01 = sequence numbers restarted (slave was reset)
+  byte 5 = reserved
+
+transaction header master -> slave [6 bytes]:
+  byte 0..1 = crc16 checksum over bytes 2..5 (LSB), master sends all zero
+              if it has nothing to acknowledge
+  byte 2 = protocol version (2)
+  byte 3 = number of messages (remote commands) in this transaction
+  byte 4..5 = acknowledge, sequence number of the last message the master
+              received in order (LSB)
+
+followed by each message:
+  byte 0..1 = crc16 checksum over bytes 2..n (LSB)
+  byte 2..3 = sequence number (LSB)
+  byte 4 = port
+  byte 5 = payload size
+  byte 6..n = payload
+
+Messages stay in the outbox until the master acknowledged them. The master
+can only acknowledge a transaction in one of the following transactions. If
+the acknowledge is behind messages which were already clocked out before,
+the master missed them, and the slave sends again from the first missed
+message on (go-back-N). The master discards messages out of sequence.
+Flushing the send queue drops the messages in the outbox which were not yet
+clocked out or armed; those which were are sent until acknowledged.
+
+Two transactions are queued to the driver at once (ping-pong buffers), so
+the master can drain a backlog in back-to-back transactions. While messages
+are waiting for acknowledge, the slave keeps a transaction armed, even if
+it is empty.
+*/
+
+#define SPI_BUFFERS 2
+#define SPI_OUTBOX_SIZE SEND_QUEUE_SIZE
+#define TRANS_HEADER_SIZE 6
+#define MSG_HEADER_SIZE 6
+#define SPI_FLAG_SYNC 0x01
+
+DMA_ATTR uint8_t txbuf[SPI_BUFFERS][SPI_V2_BUFFER_SIZE];
+DMA_ATTR uint8_t rxbuf[SPI_BUFFERS][SPI_V2_BUFFER_SIZE];
+
+// messages taken from send queue, until they are acknowledged by master
+static MessageBuffer_t outbox[SPI_OUTBOX_SIZE];
+static uint32_t outbox_started[SPI_OUTBOX_SIZE]; // first clocked out [ms]
+static volatile uint8_t outbox_count = 0; // unacknowledged messages
+static uint8_t outbox_head = 0;           // slot of oldest message
+static uint8_t outbox_next = 0;           // next message to send, from head
+static uint16_t outbox_seq = 0;           // sequence number of oldest message
+
+static uint16_t clocked_seq = 0;  // next sequence number after clocked out
+static uint8_t epoch = 0;         // incremented when we go back
+static uint8_t clocked_epoch = 0; // epoch of last finished transaction
+static bool seq_sync = true;      // no acknowledge received since restart
+static volatile bool outbox_flush = false; // set by spi_queuereset()
+
+// state of ping-pong transaction buffers
+typedef struct {
+  spi_slave_transaction_t trans;
+  bool armed;
+  uint8_t epoch;                 // epoch when buffer was armed
+  uint8_t count;                 // number of messages in buffer
+  uint16_t seq;                  // sequence number of first message
+  uint16_t end[SPI_OUTBOX_SIZE]; // end offset of messages in buffer
+} spiBuffer_t;
+
+static spiBuffer_t spibuf[SPI_BUFFERS];
+
+// move messages from send queue to outbox, wait for one if nothing to do
+static void spi_fetch(TickType_t wait) {
+  while (outbox_count < SPI_OUTBOX_SIZE) {
+    uint8_t i = (outbox_head + outbox_count) % SPI_OUTBOX_SIZE;
+    if (xQueueReceive(SPISendQueue, &outbox[i], wait) != pdTRUE)
+      break;
+    outbox_started[i] = 0;
+    outbox_count++;
+    wait = 0;
+  }
+}
+
+// fill transaction buffer with next messages from outbox
+static bool spi_arm(int b) {
+  spiBuffer_t *sb = &spibuf[b];
+  uint8_t *buf = txbuf[b];
+  size_t cursor = TRANS_HEADER_SIZE;
+
+  sb->count = 0;
+  sb->seq = outbox_seq + outbox_next;
+  while (outbox_next < outbox_count) {
+    uint8_t i = (outbox_head + outbox_next) % SPI_OUTBOX_SIZE;
+    MessageBuffer_t *msg = &outbox[i];
+    if (cursor + MSG_HEADER_SIZE + msg->MessageSize > SPI_V2_BUFFER_SIZE)
+      break;
+    if (!outbox_started[i])
+      outbox_started[i] = millis() | 1; // 0 = not yet sent
+    uint16_t seq = sb->seq + sb->count;
+    buf[cursor + 2] = lowByte(seq);
+    buf[cursor + 3] = highByte(seq);
+    buf[cursor + 4] = msg->MessagePort;
+    buf[cursor + 5] = msg->MessageSize;
+    memcpy(buf + cursor + MSG_HEADER_SIZE, msg->Message, msg->MessageSize);
+    uint16_t crc =
+        crc16_be(0, buf + cursor + 2, msg->MessageSize + MSG_HEADER_SIZE - 2);
+    buf[cursor] = lowByte(crc);
+    buf[cursor + 1] = highByte(crc);
+    cursor += MSG_HEADER_SIZE + msg->MessageSize;
+    sb->end[sb->count++] = cursor;
+    outbox_next++;
+  }
+
+  buf[2] = SPI_PROTOCOL;
+  buf[3] = sb->count;
+  buf[4] = seq_sync ? SPI_FLAG_SYNC : 0;
+  buf[5] = 0;
+  uint16_t crc = crc16_be(0, buf + 2, TRANS_HEADER_SIZE - 2);
+  buf[0] = lowByte(crc);
+  buf[1] = highByte(crc);
+  // invalidate header of a previous transaction in rx buffer
+  memset(rxbuf[b], 0, TRANS_HEADER_SIZE + MSG_HEADER_SIZE);
+
+  memset(&sb->trans, 0, sizeof(sb->trans));
+  sb->trans.length = SPI_V2_BUFFER_SIZE * 8;
+  sb->trans.tx_buffer = txbuf[b];
+  sb->trans.rx_buffer = rxbuf[b];
+  sb->epoch = epoch;
+
+  if (spi_slave_queue_trans(HSPI_HOST, &sb->trans, 0) != ESP_OK) {
+    outbox_next -= sb->count;
+    return false;
+  }
+
+  ESP_LOGD(TAG, "Prepared SPI transaction with %u message(s), %zu byte(s)",
+           sb->count, cursor);
+  sb->armed = true;
+  return true;
+}
+
+// process acknowledge of master, free acknowledged messages from outbox
+static void spi_ack(uint16_t ack) {
+  int16_t n = (int16_t)(ack + 1 - outbox_seq);
+
+  // acknowledge for messages we no longer have or did not yet send
+  if (n <= 0 || n > outbox_next)
+    return;
+
+  for (int16_t i = 0; i < n; i++) {
+    uint8_t slot = (outbox_head + i) % SPI_OUTBOX_SIZE;
+    stats_sent(TRANSPORT_SPI, outbox[slot].MessageTime, outbox_started[slot]);
+  }
+
+  outbox_head = (outbox_head + n) % SPI_OUTBOX_SIZE;
+  outbox_count -= n;
+  outbox_next -= n;
+  outbox_seq += n;
+  seq_sync = false;
+  ESP_LOGD(TAG, "Master acknowledged %d message(s) up to #%u", n, ack);
+}
+
+// drop messages from outbox which the master has not seen yet. Messages
+// already clocked out or armed in a transaction are kept, their sequence
+// numbers must not be used again, else the master would discard the
+// following messages as duplicates.
+static void spi_flush(void) {
+  uint16_t seen = clocked_seq;
+  for (int b = 0; b < SPI_BUFFERS; b++) {
+    uint16_t end = spibuf[b].seq + spibuf[b].count;
+    if (spibuf[b].armed && (int16_t)(end - seen) > 0)
+      seen = end;
+  }
+  int16_t keep = constrain((int16_t)(seen - outbox_seq), 0, outbox_count);
+  ESP_LOGI(TAG, "Flushed %d message(s) from SPI outbox", outbox_count - keep);
+  outbox_count = keep;
+  if (outbox_next > keep)
+    outbox_next = keep;
+}
+
+// evaluate finished transaction
+static void spi_complete(int b) {
+  spiBuffer_t *sb = &spibuf[b];
+  size_t clocked = sb->trans.trans_len / 8;
+  uint8_t *rx = rxbuf[b];
+  uint8_t sent = 0;
+
+  sb->armed = false;
+
+  // check header received from master
+  bool valid = (clocked >= TRANS_HEADER_SIZE) && (rx[2] == SPI_PROTOCOL) &&
+               ((rx[0] | (rx[1] << 8)) ==
+                crc16_be(0, rx + 2, TRANS_HEADER_SIZE - 2));
+
+  // acknowledge reflects transactions which finished before this one
+  if (valid) {
+    uint16_t ack = rx[4] | (rx[5] << 8);
+    spi_ack(ack);
+    // master missed messages clocked out earlier -> go back, but only once
+    // for all transactions armed before
+    if ((int16_t)(clocked_seq - (uint16_t)(ack + 1)) > 0 &&
+        clocked_epoch == epoch) {
+      ESP_LOGI(TAG, "Master missed message(s) after #%u, sending again", ack);
+      stats_retried(TRANSPORT_SPI, outbox_next);
+      outbox_next = 0;
+      epoch++;
+    }
+  }
+
+  // count messages completely clocked out by master
+  while (sent < sb->count && sb->end[sent] <= clocked)
+    sent++;
+  if (sent)
+    clocked_seq = sb->seq + sent;
+
+  // messages cut off by a short transaction are sent again
+  if (sent < sb->count && sb->epoch == epoch) {
+    int16_t n = (int16_t)(sb->seq + sent - outbox_seq);
+    if (n >= 0 && n < outbox_next) {
+      stats_retried(TRANSPORT_SPI, outbox_next - n);
+      outbox_next = n;
+      epoch++;
+    }
+  }
+  clocked_epoch = sb->epoch;
+
+  ESP_LOGI(TAG, "Transaction finished with %zu byte(s), %u of %u message(s)",
+           clocked, sent, sb->count);
+
+  // check if command was received, then call interpreter with command payload
+  uint8_t *msg = rx + TRANS_HEADER_SIZE;
+  if (valid && rx[3] && (msg[4] == RCMDPORT)) {
+    uint8_t size = msg[5];
+    uint16_t crc = msg[0] | (msg[1] << 8);
+    if ((TRANS_HEADER_SIZE + MSG_HEADER_SIZE + size <= clocked) &&
+        (crc == crc16_be(0, msg + 2, size + MSG_HEADER_SIZE - 2)))
+      rcommand(msg + MSG_HEADER_SIZE, size);
+    else
+      ESP_LOGW(TAG, "Invalid command received on SPI");
+  }
+}
+
+void spi_slave_task(void *param) {
+  spi_slave_transaction_t *done;
+
+  while (1) {
+    if (outbox_flush) {
+      outbox_flush = false;
+      spi_flush();
+    }
+
+    int armed = spibuf[0].armed + spibuf[1].armed;
+
+    // fetch messages from queue, block if we have nothing to send
+    spi_fetch(armed || outbox_count ? 0 : portMAX_DELAY);
+
+    // arm idle buffers with messages to send, keep at least one buffer armed
+    // while messages wait for acknowledge
+    for (int b = 0; b < SPI_BUFFERS; b++)
+      if (!spibuf[b].armed &&
+          (outbox_next < outbox_count || (outbox_count && !armed)) &&
+          spi_arm(b))
+        armed++;
+
+    if (!armed) {
+      // could not queue transaction to driver, try again later
+      vTaskDelay(pdMS_TO_TICKS(SPI_V2_POLL_MS));
+      continue;
+    }
+
+    // wait until spi master clocks out a transaction, if only one buffer is
+    // armed poll send queue meanwhile to fill the second one
+    if (spi_slave_get_trans_result(HSPI_HOST, &done,
+                                   armed < SPI_BUFFERS
+                                       ? pdMS_TO_TICKS(SPI_V2_POLL_MS)
+                                       : portMAX_DELAY) == ESP_OK)
+      spi_complete(done == &spibuf[0].trans ? 0 : 1);
+  }
+}
+
+#else // SPI_PROTOCOL == 1
+
+#define SPI_BUFFERS 1
+
 // SPI transaction size needs to be at least 8 bytes and dividable by 4, see
 // https://docs.espressif.com/projects/esp-idf/en/latest/api-reference/peripherals/spi_slave.html
 #define BUFFER_SIZE                                                            \
@@ -41,10 +336,6 @@ licenses. Refer to LICENSE.txt file in repository for more details.
 DMA_ATTR uint8_t txbuf[BUFFER_SIZE];
 DMA_ATTR uint8_t rxbuf[BUFFER_SIZE];
 
-static QueueHandle_t SPISendQueue;
-
-TaskHandle_t spiTask;
-
 void spi_slave_task(void *param) {
   while (1) {
     MessageBuffer_t msg;
@@ -89,6 +380,7 @@ void spi_slave_task(void *param) {
     // wait until spi master clocks out the data, and read results in rx buffer
     ESP_LOGI(TAG, "Prepared SPI transaction for %zu byte(s)", transaction_size);
     ESP_LOG_BUFFER_HEXDUMP(TAG, txbuf, transaction_size, ESP_LOG_DEBUG);
+    uint32_t started = millis();
     spi_slave_transmit(HSPI_HOST, &spi_transaction, portMAX_DELAY);
     ESP_LOG_BUFFER_HEXDUMP(TAG, rxbuf, transaction_size, ESP_LOG_DEBUG);
     ESP_LOGI(TAG, "Transaction finished with size %zu bits",
@@ -96,6 +388,7 @@ void spi_slave_task(void *param) {
 
     // delete sent item from queue
     xQueueReceive(SPISendQueue, &msg, (TickType_t)0);
+    stats_sent(TRANSPORT_SPI, msg.MessageTime, started);
 
     // check if command was received, then call interpreter with command payload
     if ((spi_transaction.trans_len) && ((rxbuf[2]) == RCMDPORT)) {
@@ -104,11 +397,13 @@ void spi_slave_task(void *param) {
   }
 }
 
+#endif // SPI_PROTOCOL
+
 void spi_deinit(void) { vTaskDelete(spiTask); }
 
 esp_err_t spi_init(void) {
   _ASSERT(SEND_QUEUE_SIZE > 0);
-  SPISendQueue = xQueueCreate(SEND_QUEUE_SIZE, sizeof(MessageBuffer_t));
+  SPISendQueue = QUEUE_CREATE(SEND_QUEUE_SIZE, sizeof(MessageBuffer_t));
   if (SPISendQueue == 0) {
     ESP_LOGE(TAG, "Could not create SPI send queue. Aborting.");
     return ESP_FAIL;
@@ -126,7 +421,7 @@ esp_err_t spi_init(void) {
 
   spi_slave_interface_config_t spi_slv_cfg = {.spics_io_num = SPI_CS,
                                               .flags = 0,
-                                              .queue_size = 1,
+                                              .queue_size = SPI_BUFFERS,
                                               .mode = 0,
                                               .post_setup_cb = NULL,
                                               .post_trans_cb = NULL};
@@ -142,7 +437,8 @@ esp_err_t spi_init(void) {
 
   if (ret == ESP_OK) {
     ESP_LOGI(TAG, "Starting SPIloop...");
-    xTaskCreate(spi_slave_task, "spiloop", 4096, (void *)NULL, 2, &spiTask);
+    TASK_CREATE(spi_slave_task, "spiloop", 4096, (void *)NULL, 2, &spiTask,
+                tskNO_AFFINITY);
   } else {
     ESP_LOGE(TAG, "SPI interface initialization failed");
   }
@@ -152,12 +448,27 @@ esp_err_t spi_init(void) {
 
 void spi_enqueuedata(MessageBuffer_t *message) {
   // enqueue message in SPI send queue
-  if (xQueueSendToBack(SPISendQueue, (void *)message, (TickType_t)0) != pdTRUE)
+  if (xQueueSendToBack(SPISendQueue, (void *)message, (TickType_t)0) !=
+      pdTRUE) {
     ESP_LOGW(TAG, "SPI sendqueue is full");
+    stats_dropped(TRANSPORT_SPI);
+  } else
+    stats_enqueued(TRANSPORT_SPI, spi_queuewaiting());
 }
 
-void spi_queuereset(void) { xQueueReset(SPISendQueue); }
+void spi_queuereset(void) {
+  xQueueReset(SPISendQueue);
+#if (SPI_PROTOCOL == 2)
+  outbox_flush = true; // outbox belongs to spi task, which flushes it
+#endif
+}
 
-uint32_t spi_queuewaiting(void) { return uxQueueMessagesWaiting(SPISendQueue); }
+uint32_t spi_queuewaiting(void) {
+#if (SPI_PROTOCOL == 2)
+  return uxQueueMessagesWaiting(SPISendQueue) + outbox_count;
+#else
+  return uxQueueMessagesWaiting(SPISendQueue);
+#endif
+}
 
 #endif // HAS_SPI
\ No newline at end of file
@@ -0,0 +1,164 @@
+// Basic Config
+#include "telemetry.h"
+#include "cyclic.h"
+
+// tasks sampled each housekeeping cycle
+static TaskHandle_t idleTask[portNUM_PROCESSORS];
+
+static const struct {
+  telemetryTask_t id;
+  const char *name;
+  TaskHandle_t *handle;
+} tasks[] = {
+    {TM_IDLE0, "IDLE0", &idleTask[0]},
+#if (portNUM_PROCESSORS > 1)
+    {TM_IDLE1, "IDLE1", &idleTask[1]},
+#endif
+    {TM_IRQHANDLER, "IRQhandler", &irqHandlerTask},
+    {TM_RCOMMAND, "Rcommand interpreter", &rcmdTask},
+#if (HAS_LORA)
+    {TM_LMIC, "LMiCtask", &lmicTask},
+    {TM_LORASEND, "Lorasendtask", &lorasendTask},
+#endif
+#if (HAS_GPS)
+    {TM_GPS, "Gpsloop", &GpsTask},
+#endif
+#ifdef HAS_SPI
+    {TM_SPI, "spiloop", &spiTask},
+#endif
+#ifdef HAS_MQTT
+    {TM_MQTT, "MQTTloop", &mqttTask},
+#endif
+#if (defined HAS_DCF77 || defined HAS_IF482)
+    {TM_CLOCK, "Clockloop", &ClockTask},
+#endif
+#if (HAS_LED != NOT_A_PIN) || defined(HAS_RGB_LED)
+    {TM_LED, "LEDloop", &ledLoopTask},
+#endif
+#ifdef HAS_BUTTON
+    {TM_BUTTON, "Buttonloop", &buttonLoopTask},
+#endif
+#if (HAS_DISPLAY) > 1
+    {TM_DPFLUSH, "Displayflush", &dpFlushTask},
+#endif
+};
+
+#define TASK_COUNT (sizeof(tasks) / sizeof(tasks[0]))
+static_assert(TASK_COUNT <= TELEMETRY_TASKS, "too many telemetry tasks");
+
+static portMUX_TYPE telemetry_mux = portMUX_INITIALIZER_UNLOCKED;
+static telemetry_t telemetry;
+
+// free heap and largest free block of the last cycles, for trends
+static uint32_t heap_free[HEAP_TREND_CYCLES], heap_block[HEAP_TREND_CYCLES];
+static uint8_t heap_samples, heap_next;
+
+// change per hour, least squares slope over all samples, so that a single
+// outlier at either end of the window does not make a trend
+static int32_t heap_trend(const uint32_t sample[]) {
+  if (heap_samples < 2)
+    return 0;
+  uint8_t oldest = heap_samples < HEAP_TREND_CYCLES ? 0 : heap_next;
+  int64_t mean = 0, cov = 0, var = 0;
+  for (uint8_t i = 0; i < heap_samples; i++)
+    mean += sample[(oldest + i) % HEAP_TREND_CYCLES];
+  mean /= heap_samples;
+  // x centered on the middle of the window, doubled to stay integer
+  for (uint8_t i = 0; i < heap_samples; i++) {
+    int64_t x = 2 * i - (heap_samples - 1);
+    cov += x * ((int64_t)sample[(oldest + i) % HEAP_TREND_CYCLES] - mean);
+    var += x * x;
+  }
+  return cov * 2 * 3600 / (var * HOMECYCLE);
+}
+
+#if (TELEMETRY_RUNTIME)
+// run time counters of the previous sample, to get the load of last cycle
+static uint32_t last_runtime[TASK_COUNT], last_time;
+#endif
+
+// sample stack, CPU and heap usage, called each housekeeping cycle
+void telemetry_sample(void) {
+  telemetry_t t;
+  t.heap_min = ESP.getMinFreeHeap();
+  t.heap_block = ESP.getMaxAllocHeap();
+  t.tasks = 0;
+
+  heap_free[heap_next] = ESP.getFreeHeap();
+  heap_block[heap_next] = t.heap_block;
+  heap_next = (heap_next + 1) % HEAP_TREND_CYCLES;
+  if (heap_samples < HEAP_TREND_CYCLES)
+    heap_samples++;
+  t.heap_trend = heap_trend(heap_free);
+  t.block_trend = heap_trend(heap_block);
+  ESP_LOGD(TAG, "Heap trend: free %+d bytes/h, largest block %+d bytes/h",
+           t.heap_trend, t.block_trend);
+
+  for (int i = 0; i < portNUM_PROCESSORS; i++)
+    if (idleTask[i] == NULL)
+      idleTask[i] = xTaskGetIdleTaskHandleForCPU(i);
+
+#if (TELEMETRY_RUNTIME)
+  uint32_t now = portGET_RUN_TIME_COUNTER_VALUE();
+  uint32_t elapsed = now - last_time;
+  last_time = now;
+#endif
+
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    TaskHandle_t task = *tasks[i].handle;
+    if (task == NULL)
+      continue;
+
+    taskStats_t *s = &t.task[t.tasks++];
+    s->id = tasks[i].id;
+    s->cpu = TELEMETRY_CPU_NA;
+#if (TELEMETRY_RUNTIME)
+    TaskStatus_t status;
+    vTaskGetInfo(task, &status, pdTRUE, eInvalid);
+    s->stack = status.usStackHighWaterMark;
+    if (elapsed && last_runtime[i]) {
+      uint32_t used = status.ulRunTimeCounter - last_runtime[i];
+      s->cpu = min((uint64_t)200, (uint64_t)used * 200 / elapsed);
+    }
+    last_runtime[i] = status.ulRunTimeCounter;
+#else
+    s->stack = uxTaskGetStackHighWaterMark(task);
+#endif
+
+    if (s->stack < TELEMETRY_STACK_LOW)
+      ESP_LOGW(TAG, "%s stack low, %d bytes left", tasks[i].name, s->stack);
+    else if (s->cpu != TELEMETRY_CPU_NA)
+      ESP_LOGD(TAG, "%s %d bytes left | Taskstate = %d | CPU %d.%d%%",
+               tasks[i].name, s->stack, eTaskGetState(task), s->cpu / 2,
+               s->cpu % 2 * 5);
+    else
+      ESP_LOGD(TAG, "%s %d bytes left | Taskstate = %d", tasks[i].name,
+               s->stack, eTaskGetState(task));
+  }
+
+  portENTER_CRITICAL(&telemetry_mux);
+  telemetry = t;
+  portEXIT_CRITICAL(&telemetry_mux);
+}
+
+// get a consistent copy of the last sample
+void telemetry_get(telemetry_t *value) {
+  portENTER_CRITICAL(&telemetry_mux);
+  *value = telemetry;
+  portEXIT_CRITICAL(&telemetry_mux);
+}
+
+// tell a leak from fragmentation, based on the last sample; a leak needs a
+// full trend window falling by at least HEAP_LEAK_TREND
+heapState_t telemetry_heapstate(void) {
+  telemetry_t t;
+  telemetry_get(&t);
+  if (ESP.getFreeHeap() <= MEM_LOW)
+    return (heap_samples == HEAP_TREND_CYCLES &&
+            t.heap_trend <= -HEAP_LEAK_TREND)
+               ? HEAP_LEAK
+               : HEAP_LOW;
+  if (t.heap_block <= MEM_LOW)
+    return HEAP_FRAGMENTED;
+  return HEAP_OK;
+}
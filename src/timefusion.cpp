@@ -0,0 +1,93 @@
+// Basic Config
+#include "timefusion.h"
+#include "clockdisc.h"
+
+/* fusion of time from multiple sources
+
+Each time source delivers its offset to system time together with an error
+bound, which depends on the quality of the source (PPS pulse, age of the last
+RTC setting, spread of LORA timeserver answers). The system clock itself is a
+source too: its error bound is the error of the last fusion, growing by the
+drift remaining after drift compensation (see clockdisc.cpp) since then. The
+bound is kept over deep sleep, growing by the error of the sleep clock model
+(see reset.cpp), so a time set after wakeup still has a known error.
+
+The offsets are combined weighted by inverse variance, so a poor source only
+slightly corrects a clock which is already good. The combined error bound is
+kept to decide when time sources need to be polled, and whether time is good
+enough to drive clock outputs or sync wakeups.
+*/
+
+// [ms] at last fusion, kept over deep sleep
+static RTC_DATA_ATTR uint32_t fused_error = TIME_ERROR_UNKNOWN;
+static int64_t fused_time = 0; // [ms] esp_timer time of fusion
+
+// current error bound of system time [ms]
+uint32_t time_errorbound(void) {
+  if ((timeSource == _unsynced) || (fused_error == TIME_ERROR_UNKNOWN))
+    return TIME_ERROR_UNKNOWN;
+  int64_t age = esp_timer_get_time() / 1000LL - fused_time;
+  uint64_t error = fused_error + (uint64_t)(age * clock_drift_error() / 1e6);
+  return min(error, (uint64_t)(TIME_ERROR_UNKNOWN - 1));
+}
+
+// system time was set from a source without error bound
+void time_forget(void) { fused_error = TIME_ERROR_UNKNOWN; }
+
+// keep error bound over deep sleep, called before sleep
+void time_sleep(void) { fused_error = time_errorbound(); }
+
+// add error of sleep clock, called after wakeup from deep sleep
+void time_wakeup(int64_t slept_ms, uint32_t drift_ppm) {
+  if (fused_error == TIME_ERROR_UNKNOWN)
+    return;
+  uint64_t error = fused_error + (uint64_t)slept_ms * drift_ppm / 1000000ULL;
+  fused_error = min(error, (uint64_t)(TIME_ERROR_UNKNOWN - 1));
+  fused_time = esp_timer_get_time() / 1000LL;
+  ESP_LOGI(TAG, "Time error after deep sleep: %u ms", fused_error);
+}
+
+// is system time within required accuracy? 0 requires only a valid time
+bool time_accurate(uint32_t required) {
+  if (!required)
+    return (timeSource != _unsynced);
+  return (time_errorbound() <= required);
+}
+
+// combine samples with system time and correct system time
+bool time_fuse(const timeSample_t samples[], uint8_t count) {
+  double wsum = 0, osum = 0, w;
+  uint8_t best = 0;
+  uint32_t err = time_errorbound();
+
+  if (!count)
+    return false;
+
+  // system time is a sample with offset 0, if we have a valid time
+  if (err != TIME_ERROR_UNKNOWN)
+    wsum = 1.0 / ((double)err * err + 1);
+
+  for (int i = 0; i < count; i++) {
+    w = 1.0 / ((double)samples[i].error * samples[i].error + 1);
+    wsum += w;
+    osum += w * samples[i].offset;
+    if (samples[i].error < samples[best].error)
+      best = i;
+    ESP_LOGD(TAG, "Time source %c: offset %lld ms, error %u ms",
+             timeSetSymbols[samples[i].source], samples[i].offset,
+             samples[i].error);
+  }
+
+  int64_t offset = (int64_t)(osum / wsum);
+  uint32_t fused = (uint32_t)(1.0 / sqrt(wsum));
+
+  // the best source names the time source, even if we only slightly adjust
+  if (!clock_adjust(offset, samples[best].source))
+    return false;
+
+  fused_error = max(fused, (uint32_t)1);
+  fused_time = esp_timer_get_time() / 1000LL;
+  ESP_LOGI(TAG, "Time fused from %u source(s): corrected %lld ms, error %u ms",
+           count, offset, fused_error);
+  return true;
+}
@@ -1,4 +1,7 @@
 #include "timekeeper.h"
+#include "clockdisc.h"
+#include "timefusion.h"
+#include "reset.h"
 
 #if (defined HAS_DCF77 && defined HAS_IF482)
 #error You must define at most one of IF482 or DCF77!
@@ -21,17 +24,13 @@ timesource_t timeSource = _unsynced;
 TaskHandle_t ClockTask = NULL;
 hw_timer_t *ppsIRQ = NULL;
 
-#ifdef HAS_IF482
-HardwareSerial IF482(2); // use UART #2 (#1 may be in use for serial GPS)
-static TickType_t txDelay = pdMS_TO_TICKS(1000 - IF482_SYNC_FIXUP) -
-                            tx_Ticks(IF482_FRAME_SIZE, HAS_IF482);
-#if (HAS_SDS011)
-#error cannot use IF482 together with SDS011 (both use UART#2)
+#if (defined HAS_IF482 || defined HAS_DCF77)
+hw_timer_t *clockTickIRQ = NULL;
+static DRAM_ATTR time_t clock_second = 0; // second of last pps
+static DRAM_ATTR uint8_t clock_tick = 0;  // 10ms ticks since last pps
 #endif
 
-#endif // HAS_IF482
-
-Ticker timesyncer;
+JobTimer timesyncer;
 
 void setTimeSyncIRQ() { xTaskNotify(irqHandlerTask, TIMESYNC_IRQ, eSetBits); }
 
@@ -62,7 +61,17 @@ void CLOCKIRQ(void) {
 
 // advance wall clock, if we have
 #if (defined HAS_IF482 || defined HAS_DCF77)
-  xTaskNotifyFromISR(ClockTask, uint32_t(time(NULL)), eSetBits,
+  clock_second = time(NULL);
+  clock_tick = 0;
+  // re-phase 10ms tick to this pps, else it keeps its free running phase
+  if (clockTickIRQ != NULL) {
+    timerWrite(clockTickIRQ, 0);
+    timerAlarmEnable(clockTickIRQ);
+  }
+#ifdef HAS_DCF77
+  DCF77_Second(clock_second);
+#endif
+  xTaskNotifyFromISR(ClockTask, uint32_t(clock_second), eSetBits,
                      &xHigherPriorityTaskWoken);
 #endif
 
@@ -81,7 +90,28 @@ void CLOCKIRQ(void) {
     portYIELD_FROM_ISR();
 }
 
+#if (defined HAS_IF482 || defined HAS_DCF77)
+// interrupt service routine triggered each 10ms, clocks out wall clock signal
+void IRAM_ATTR CLOCKTICKIRQ(void) {
+  if (clock_tick < UINT8_MAX)
+    clock_tick++;
+#ifdef HAS_DCF77
+  DCF77_Tick(clock_tick);
+#elif defined HAS_IF482
+  IF482_Tick(clock_tick, clock_second);
+#endif
+}
+#endif
+
 void calibrateTime(void) {
+  // don't poll time sources while time is accurate enough
+  if (TIME_SYNC_ACCURACY && time_accurate(TIME_SYNC_ACCURACY)) {
+    ESP_LOGD(TAG, "[%0.3f] Time within %u ms, no sync needed", _seconds(),
+             time_errorbound());
+    timesyncer.attach(clock_syncinterval() * 60, setTimeSyncIRQ);
+    return;
+  }
+
   // kick off asynchronous lora timesync if we have
 #if (HAS_LORA_TIME)
   timesync_request();
@@ -90,23 +120,35 @@ void calibrateTime(void) {
 #endif
 
 #if ((HAS_GPS) || defined HAS_RTC)
+  timeSample_t samples[2];
+  uint8_t count = 0;
   time_t t = 0;
   uint16_t t_msec = 0;
 
 // get GPS time, if we have
 #if (HAS_GPS)
   t = get_gpstime(&t_msec);
-  if (setMyTime((uint32_t)t, t_msec, _gps))
-    return;
+  if (timeIsValid(t)) {
+    samples[count].offset = clock_offset(t, t_msec);
+    samples[count].error = get_gpserror();
+    samples[count++].source = _gps;
+  }
 #endif
 
-// fallback to RTC time, if we have
+// get RTC time, if we have
 #ifdef HAS_RTC
   t = get_rtctime(&t_msec);
-  if (setMyTime((uint32_t)t, t_msec, _rtc))
-    return;
+  if (timeIsValid(t)) {
+    samples[count].offset = clock_offset(t, t_msec);
+    samples[count].error = get_rtcerror();
+    samples[count++].source = _rtc;
+  }
 #endif
 
+  // combine sources weighted by their errors
+  if (!time_fuse(samples, count))
+    timesyncer.attach(TIME_SYNC_INTERVAL_RETRY * 60, setTimeSyncIRQ);
+
 #endif
 } // calibrateTime()
 
@@ -123,6 +165,12 @@ bool setMyTime(uint32_t t_sec, uint16_t t_msec, timesource_t mytimesource) {
 
   // do we have a valid time?
   if (timeIsValid(time_to_set)) {
+    // let deep sleep learn from the error of the time we had
+    gettimeofday(&tv, NULL);
+    sleep_learn(((int64_t)t_sec - tv.tv_sec) * 1000LL + t_msec -
+                    tv.tv_usec / 1000,
+                mytimesource);
+
     // if we have msec fraction, then wait until top of second with
     // millisecond precision
     if (t_msec % 1000) {
@@ -153,7 +201,7 @@ bool setMyTime(uint32_t t_sec, uint16_t t_msec, timesource_t mytimesource) {
 
     timeSource = mytimesource; // set global variable
 
-    timesyncer.attach(TIME_SYNC_INTERVAL * 60, setTimeSyncIRQ);
+    timesyncer.attach(clock_syncinterval() * 60, setTimeSyncIRQ);
     ESP_LOGD(TAG, "[%0.3f] Timesync finished, time was set | timesource=%d",
              _seconds(), mytimesource);
     return true;
@@ -230,17 +278,12 @@ TickType_t tx_Ticks(uint32_t framesize, unsigned long baud, uint32_t config,
 
 void clock_loop(void *taskparameter) { // ClockTask
   uint32_t current_time = 0, previous_time = 0;
-  time_t tt;
-  struct tm t = {0};
 #ifdef HAS_TWO_LED
   static bool led1_state = false;
 #endif
-#ifdef HAS_DCF77
-  uint64_t ClockPulse = 0;
-  int8_t ClockMinute = -1;
-#endif
 
-  // output the next second's pulse/telegram after pps arrived
+  // prepare the next second's telegram or minute's pulse frame after pps
+  // arrived, the clock tick interrupt sends it out
   for (;;) {
     // wait for timepulse and store UTC time
     xTaskNotifyWait(0x00, ULONG_MAX, &current_time, portMAX_DELAY);
@@ -249,48 +292,16 @@ void clock_loop(void *taskparameter) { // ClockTask
         !(timeIsValid(current_time)) || (current_time == previous_time))
       continue;
 
-    // set calendar time for next second of clock output
-    tt = (time_t)(current_time + 1);
-    localtime_r(&tt, &t);
-    tt = mktime(&t);
-
-#if defined HAS_IF482
-
-    // wait until moment to fire. Normally we won't get notified during this
-    // timespan, except when next pps pulse arrives while waiting, because pps
-    // was adjusted by recent time sync, then advance next_time one second
-    if (xTaskNotifyWait(0x00, ULONG_MAX, &current_time, txDelay) == pdTRUE) {
-      tt = (time_t)(current_time + 1);
-      localtime_r(&tt, &t);
-      tt = mktime(&t);
+    // don't drive a clock with poor time
+    if (!time_accurate(TIME_CLOCK_ACCURACY)) {
+      previous_time = current_time;
+      continue;
     }
 
-    // send IF482 telegram
-    IF482.print(IF482_Frame(tt)); // note: telegram is for *next* second
-
-    ESP_LOGD(TAG, "[%0.3f] IF482: %s", _seconds(), IF482_Frame(tt).c_str());
-
+#if defined HAS_IF482
+    IF482_Schedule(current_time); // note: telegram is for *next* second
 #elif defined HAS_DCF77
-
-    // load new frame if second 59 is reached
-    if (t.tm_sec == 0) {
-      ClockMinute = t.tm_min;
-      t.tm_min++;                  // follow-up minute
-      mktime(&t);                  // normalize calendar time
-      ClockPulse = DCF77_Frame(t); // generate pulse frame
-
-      /* to do here: leap second handling in second 59 */
-
-      ESP_LOGD(TAG, "[%0.3f] DCF77: new frame for min %d", _seconds(),
-               t.tm_min);
-    } else {
-      // generate impulse
-      if (t.tm_min == ClockMinute) { // ensure frame is recent
-        DCF77_Pulse(ClockPulse & 1); // output next second
-        ClockPulse >>= 1;
-      }
-    }
-
+    DCF77_Schedule(current_time); // note: frame is for *next* minute
 #endif
 
 // pps blink on secondary LED if we have one
@@ -309,79 +320,37 @@ void clock_loop(void *taskparameter) { // ClockTask
 void clock_init(void) {
 // setup clock output interface
 #ifdef HAS_IF482
-  IF482.begin(HAS_IF482);
+  IF482_Init();
 #elif defined HAS_DCF77
   pinMode(HAS_DCF77, OUTPUT);
+  digitalWrite(HAS_DCF77, dcf_high);
 #endif
 
-  xTaskCreatePinnedToCore(clock_loop,  // task function
-                          "clockloop", // name of task
-                          3072,        // stack size of task
-                          (void *)1,   // task parameter
-                          6,           // priority of the task
-                          &ClockTask,  // task handle
-                          1);          // CPU core
+  // 10ms tick to clock out signal, restarted by each pps in CLOCKIRQ
+  clockTickIRQ = timerBegin(2, 80, true);     // 80 MHz / 80 = 1 MHz
+  timerAlarmWrite(clockTickIRQ, 10000, true); // 10ms
+  timerAttachInterrupt(clockTickIRQ, &CLOCKTICKIRQ, false);
+  timerAlarmEnable(clockTickIRQ);
+
+  TASK_CREATE(clock_loop,  // task function
+              "clockloop", // name of task
+              3072,        // stack size of task
+              (void *)1,   // task parameter
+              6,           // priority of the task
+              &ClockTask,  // task handle
+              1);          // CPU core
 
   _ASSERT(ClockTask != NULL); // has clock task started?
 } // clock_init
 
 // we use compile date to create a time_t reference "in the past"
 time_t compileTime(void) {
-  char s_month[5];
-  int year;
-  struct tm t = {0};
-  static const char month_names[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
-
-  // store compile time once it's calculated
-  static time_t secs = -1;
-
-  if (secs == -1) {
-    // determine date
-    sscanf(__DATE__, "%4s %d %d", s_month, &t.tm_mday, &year);
-    t.tm_mon = (strstr(month_names, s_month) - month_names) / 3;
-    t.tm_year = year - 1900;
-    // determine time
-    sscanf(__TIME__, "%d:%d:%d", &t.tm_hour, &t.tm_min, &t.tm_sec);
-
-    // convert to secs local time
-    secs = mktime(&t);
-  }
-
-  return secs;
-}
-
-static bool IsLeapYear(short year) {
-  if (year % 4 != 0)
-    return false;
-  if (year % 100 != 0)
-    return true;
-  return (year % 400) == 0;
+  // build time is local time of build machine, guess it's our time zone
+  return CAL_BUILD_TIME - cal_utcoffset(CAL_BUILD_TIME);
 }
 
 // convert UTC tm time to time_t epoch time
-time_t mkgmtime(const struct tm *ptm) {
-  const int SecondsPerMinute = 60;
-  const int SecondsPerHour = 3600;
-  const int SecondsPerDay = 86400;
-  const int DaysOfMonth[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-  time_t secs = 0;
-  // tm_year is years since 1900
-  int year = ptm->tm_year + 1900;
-  for (int y = 1970; y < year; ++y) {
-    secs += (IsLeapYear(y) ? 366 : 365) * SecondsPerDay;
-  }
-  // tm_mon is month from 0..11
-  for (int m = 0; m < ptm->tm_mon; ++m) {
-    secs += DaysOfMonth[m] * SecondsPerDay;
-    if (m == 1 && IsLeapYear(year))
-      secs += SecondsPerDay;
-  }
-  secs += (ptm->tm_mday - 1) * SecondsPerDay;
-  secs += ptm->tm_hour * SecondsPerHour;
-  secs += ptm->tm_min * SecondsPerMinute;
-  secs += ptm->tm_sec;
-  return secs;
-}
+time_t mkgmtime(const struct tm *ptm) { return cal_mkgmtime(ptm); }
 
 void time_init(void) {
 #if (defined HAS_IF482 || defined HAS_DCF77)
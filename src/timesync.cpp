@@ -20,23 +20,25 @@ accept this.
 #endif
 
 #include "timesync.h"
+#include "clockdisc.h"
 
 
 static bool timeSyncPending = false;
 static uint8_t time_sync_seqNo = (uint8_t)random(TIME_SYNC_MAX_SEQNO),
                sample_idx;
 static uint32_t timesync_timestamp[TIME_SYNC_SAMPLES][no_of_timestamps];
+static int64_t timesync_offset[TIME_SYNC_SAMPLES];
 static TaskHandle_t timeSyncProcTask;
 
 // create task for timeserver handshake processing, called from main.cpp
 void timesync_init(void) {
-  xTaskCreatePinnedToCore(timesync_processReq, // task function
-                          "timesync_proc",     // name of task
-                          4096,                // stack size of task
-                          (void *)1,           // task parameter
-                          7,                   // priority of the task
-                          &timeSyncProcTask,   // task handle
-                          1);                  // CPU core
+  TASK_CREATE(timesync_processReq, // task function
+              "timesync_proc",     // name of task
+              4096,                // stack size of task
+              (void *)1,           // task parameter
+              7,                   // priority of the task
+              &timeSyncProcTask,   // task handle
+              1);                  // CPU core
 }
 
 // kickoff asnychronous timesync handshake
@@ -55,7 +57,6 @@ void timesync_request(void) {
 // task for processing time sync request
 void timesync_processReq(void *taskparameter) {
   uint32_t rcv_seqNo = TIME_SYNC_END_FLAG;
-  uint32_t time_offset_sec = 0, time_offset_ms = 0;
 
   //  this task is an endless loop, waiting in blocked mode, until it is
   //  unblocked by timesync_request(). It then waits to be notified from
@@ -70,7 +71,7 @@ void timesync_processReq(void *taskparameter) {
 
     // initialize flag and counters
     timeSyncPending = true;
-    time_offset_ms = sample_idx = 0;
+    sample_idx = 0;
     if (++time_sync_seqNo > TIME_SYNC_MAX_SEQNO)
       time_sync_seqNo = 0;
 
@@ -81,6 +82,7 @@ void timesync_processReq(void *taskparameter) {
 
     // collect timestamp samples in timestamp array
     for (int8_t i = 0; i < TIME_SYNC_SAMPLES; i++) {
+      bool answered = false;
 // send timesync request
 #if (TIME_SYNC_LORASERVER) // ask user's timeserver (for LoRAWAN < 1.0.3)
       payload.reset();
@@ -88,11 +90,32 @@ void timesync_processReq(void *taskparameter) {
       SendPayload(TIMEPORT);
 #elif (TIME_SYNC_LORAWAN) // ask network (requires LoRAWAN >= 1.0.3)
       LMIC_requestNetworkTime(timesync_serverAnswer, &time_sync_seqNo);
-      // trigger to immediately get DevTimeAns from class A device
-      LMIC_sendAlive();
+      // DevTimeReq goes out with the next uplink, piggyback it on a data
+      // uplink if one is due soon
+      if (TIME_SYNC_PIGGYBACK &&
+          (lora_queuewaiting() ||
+           sendcycle_due(TRANSPORT_LORA, TIME_SYNC_PIGGYBACK * 1000UL))) {
+        ESP_LOGD(TAG, "[%0.3f] Time request waits for next uplink",
+                 _seconds());
+        // if the uplink goes out late, the answer comes in its rx windows
+        uint32_t wait =
+            (TIME_SYNC_PIGGYBACK + TIME_SYNC_AIRTIME + LMIC.rxDelay + 1) *
+            1000UL;
+        if (xTaskNotifyWait(0x00, ULONG_MAX, &rcv_seqNo,
+                            pdMS_TO_TICKS(wait)) == pdTRUE) {
+          // END_FLAG: uplink went out, but network did not answer
+          answered = (rcv_seqNo != TIME_SYNC_END_FLAG);
+          if (!answered)
+            LMIC_requestNetworkTime(timesync_serverAnswer, &time_sync_seqNo);
+        }
+      }
+      // otherwise trigger to immediately get DevTimeAns from class A device
+      if (!answered)
+        LMIC_sendAlive();
 #endif
       // wait until a timestamp was received
-      if (xTaskNotifyWait(0x00, ULONG_MAX, &rcv_seqNo,
+      if (!answered &&
+          xTaskNotifyWait(0x00, ULONG_MAX, &rcv_seqNo,
                           pdMS_TO_TICKS(TIME_SYNC_TIMEOUT * 1000)) == pdFALSE) {
         ESP_LOGW(TAG, "[d%0.3f] Timesync aborted: timed out", _seconds());
         goto Fail; // no timestamp received before timeout
@@ -106,9 +129,10 @@ void timesync_processReq(void *taskparameter) {
       }
 
 #if (TIME_SYNC_LORASERVER)
-      // calculate time diff with received timestamp
-      time_offset_ms += timesync_timestamp[sample_idx][timesync_rx] -
-                        timesync_timestamp[sample_idx][timesync_tx];
+      // add time diff between request and received timestamp
+      timesync_offset[sample_idx] +=
+          (int32_t)(timesync_timestamp[sample_idx][timesync_rx] -
+                    timesync_timestamp[sample_idx][timesync_tx]);
 #endif
 
       // increment sample index
@@ -119,26 +143,13 @@ void timesync_processReq(void *taskparameter) {
         vTaskDelay(pdMS_TO_TICKS(TIME_SYNC_CYCLE * 1000));
     } // for i
 
-    // --- time critial part: evaluate timestamps and calculate time ---
+    // --- time critial part: evaluate offsets and discipline clock ---
 
     // mask application irq to ensure accurate timing
     mask_user_IRQ();
 
-    // calculate average time offset over the summed up difference
-    time_offset_ms /= TIME_SYNC_SAMPLES;
-
-    // add milliseconds from latest gateway time, and apply a compensation
-    // constant for processing times on node and gateway, strip full seconds
-    time_offset_ms += timesync_timestamp[sample_idx - 1][gwtime_msec];
-    time_offset_ms -= TIME_SYNC_FIXUP;
-    time_offset_ms %= 1000;
-
-    // take latest timestamp received from gateway
-    // and add time difference rounded to whole seconds
-    time_offset_sec = timesync_timestamp[sample_idx - 1][gwtime_sec];
-    time_offset_sec += time_offset_ms / 1000;
-
-    setMyTime(time_offset_sec, time_offset_ms, _lora);
+    if (!clock_discipline(timesync_offset, sample_idx, _lora))
+      goto Fail;
 
     // send timesync end char to show timesync was successful
     payload.reset();
@@ -257,6 +268,9 @@ Finish:
     // store time received from gateway
     timesync_store(timestamp_sec, gwtime_sec);
     timesync_store(timestamp_msec, gwtime_msec);
+    // offset of received time to system time, compensated for processing
+    timesync_offset[sample_idx] =
+        clock_offset(timestamp_sec, (int32_t)timestamp_msec - TIME_SYNC_FIXUP);
     // success
     rc = 1;
   } else {
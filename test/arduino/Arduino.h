@@ -0,0 +1,27 @@
+#ifndef _ARDUINO_H
+#define _ARDUINO_H
+
+// just enough Arduino for building TinyGPS++ on the build host, to compare
+// it in the benchmark of test_nmea
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TWO_PI 6.283185307179586476925286766559
+#define radians(deg) ((deg) * (TWO_PI / 360.0))
+#define degrees(rad) ((rad) * (360.0 / TWO_PI))
+#define sq(x) ((x) * (x))
+
+typedef uint8_t byte;
+
+static inline unsigned long millis(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000UL;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef _NATIVE_H
+#define _NATIVE_H
+
+/* stand-ins for the parts of Arduino and ESP-IDF used by the platform
+independent modules, so that they can be unit tested on the build host with
+"pio test -e native". Include this before the module source. */
+
+#define _GLOBALS_H // keep the firmware's globals.h out
+
+#include <algorithm>
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+using std::max;
+using std::min;
+
+#define TAG "native"
+#define ESP_LOGD(tag, ...)
+#define ESP_LOGI(tag, ...)
+#define ESP_LOGW(tag, ...)
+#define ESP_LOGE(tag, ...)
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+// wall time [ns] for benchmarks
+static inline uint64_t native_nanos(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#endif
@@ -0,0 +1,182 @@
+// host tests of src/calendar.cpp, run with "pio test -e native"
+
+#include "../native.h"
+#include "../../src/calendar.cpp"
+#include <unity.h>
+
+#define FIRST_YEAR 1970
+#define LAST_YEAR 2100
+
+static const char *const CET = "CET-1CEST,M3.5.0,M10.5.0/3";
+static const char *const AUS = "AEST-10AEDT,M10.1.0,M4.1.0/3";
+
+static void set_host_tz(const char *s) {
+  setenv("TZ", s, 1);
+  tzset();
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static_assert(days_from_civil(1970, 1, 1) == 0, "epoch");
+static_assert(days_from_civil(2000, 3, 1) == 11017, "after leap day");
+static_assert(days_from_civil(1969, 12, 31) == -1, "before epoch");
+static_assert(weekday_from_days(0) == 4, "1970-01-01 was a thursday");
+static_assert(weekday_from_days(-1) == 3, "1969-12-31 was a wednesday");
+static_assert(!is_leap(2100) && is_leap(2000) && is_leap(2024), "leap");
+static_assert(cal_month("Sep") == 9 && cal_month("Jun") == 6, "month");
+
+// every day 1970..2100 forth and back, days counted one by one
+void test_days_round_trip(void) {
+  int32_t days = 0;
+  for (int32_t y = FIRST_YEAR; y <= LAST_YEAR; y++)
+    for (uint32_t m = 1; m <= 12; m++)
+      for (uint32_t d = 1; d <= last_day_of_month(y, m); d++, days++) {
+        int32_t y2;
+        uint32_t m2, d2;
+        TEST_ASSERT_EQUAL_INT32(days, days_from_civil(y, m, d));
+        civil_from_days(days, &y2, &m2, &d2);
+        TEST_ASSERT_EQUAL_INT32(y, y2);
+        TEST_ASSERT_EQUAL_UINT32(m, m2);
+        TEST_ASSERT_EQUAL_UINT32(d, d2);
+        TEST_ASSERT_EQUAL_UINT32((days + 4) % 7, weekday_from_days(days));
+      }
+  TEST_ASSERT_EQUAL_INT32(days, days_from_civil(LAST_YEAR + 1, 1, 1));
+}
+
+// every day 1970..2100 at a varying time of day, against the C library
+void test_gmtime_against_libc(void) {
+  time_t last = (time_t)days_from_civil(LAST_YEAR + 1, 1, 1) * SECS_PER_DAY;
+  uint32_t secs = 0;
+  for (time_t t = 0; t < last; t += SECS_PER_DAY) {
+    struct tm ref, tm;
+    time_t ts = t + secs;
+    gmtime_r(&ts, &ref);
+    cal_gmtime(ts, &tm);
+    TEST_ASSERT_EQUAL_INT(ref.tm_year, tm.tm_year);
+    TEST_ASSERT_EQUAL_INT(ref.tm_mon, tm.tm_mon);
+    TEST_ASSERT_EQUAL_INT(ref.tm_mday, tm.tm_mday);
+    TEST_ASSERT_EQUAL_INT(ref.tm_hour, tm.tm_hour);
+    TEST_ASSERT_EQUAL_INT(ref.tm_min, tm.tm_min);
+    TEST_ASSERT_EQUAL_INT(ref.tm_sec, tm.tm_sec);
+    TEST_ASSERT_EQUAL_INT(ref.tm_wday, tm.tm_wday);
+    TEST_ASSERT_EQUAL_INT(ref.tm_yday, tm.tm_yday);
+    TEST_ASSERT_TRUE(cal_mkgmtime(&tm) == ts);
+    secs = (secs + 7919) % SECS_PER_DAY;
+  }
+}
+
+void test_gmtime_before_epoch(void) {
+  struct tm tm;
+  cal_gmtime(-1, &tm);
+  TEST_ASSERT_EQUAL_INT(69, tm.tm_year);
+  TEST_ASSERT_EQUAL_INT(11, tm.tm_mon);
+  TEST_ASSERT_EQUAL_INT(31, tm.tm_mday);
+  TEST_ASSERT_EQUAL_INT(23, tm.tm_hour);
+  TEST_ASSERT_EQUAL_INT(59, tm.tm_sec);
+  TEST_ASSERT_EQUAL_INT(3, tm.tm_wday);
+}
+
+// local time around each DST transition 1970..2100, against the C library
+static void check_localtime(const char *zone) {
+  TEST_ASSERT_TRUE(cal_settz(zone));
+  set_host_tz(zone);
+  time_t last = (time_t)days_from_civil(LAST_YEAR + 1, 1, 1) * SECS_PER_DAY;
+  for (time_t t = 0; t < last; t += 3600) {
+    for (time_t ts = t - 1; ts <= t; ts++) {
+      struct tm ref, tm;
+      localtime_r(&ts, &ref);
+      cal_localtime(ts, &tm);
+      TEST_ASSERT_EQUAL_INT(ref.tm_isdst, tm.tm_isdst);
+      TEST_ASSERT_EQUAL_INT(ref.tm_year, tm.tm_year);
+      TEST_ASSERT_EQUAL_INT(ref.tm_yday, tm.tm_yday);
+      TEST_ASSERT_EQUAL_INT(ref.tm_hour, tm.tm_hour);
+      TEST_ASSERT_EQUAL_INT(ref.tm_sec, tm.tm_sec);
+    }
+  }
+}
+
+void test_localtime_northern(void) { check_localtime(CET); }
+void test_localtime_southern(void) { check_localtime(AUS); }
+
+void test_localtime_backwards(void) {
+  // walking back in time must refill the cache, not reuse it
+  TEST_ASSERT_TRUE(cal_settz(CET));
+  time_t dst_start = (time_t)days_from_civil(2024, 3, 31) * SECS_PER_DAY + 3600;
+  bool isdst;
+  TEST_ASSERT_EQUAL_INT32(7200, cal_utcoffset(dst_start, &isdst));
+  TEST_ASSERT_TRUE(isdst);
+  TEST_ASSERT_EQUAL_INT32(3600, cal_utcoffset(dst_start - 1, &isdst));
+  TEST_ASSERT_FALSE(isdst);
+  TEST_ASSERT_EQUAL_INT32(7200, cal_utcoffset(dst_start, &isdst));
+}
+
+void test_settz_malformed(void) {
+  TEST_ASSERT_FALSE(cal_settz("CET-1CEST,M13.5.0,M10.5.0/3"));
+  TEST_ASSERT_EQUAL_INT32(0, cal_utcoffset(0));
+  TEST_ASSERT_TRUE(cal_settz("<+0530>-5:30"));
+  TEST_ASSERT_EQUAL_INT32(19800, cal_utcoffset(0));
+}
+
+// --- benchmark, reports ns per call, no pass/fail ---
+
+#define BENCH_CALLS 1000000
+
+static void report(const char *what, uint64_t ns) {
+  char msg[80];
+  snprintf(msg, sizeof(msg), "%-14s %6.1f ns/call", what,
+           (double)ns / BENCH_CALLS);
+  TEST_MESSAGE(msg);
+}
+
+void test_benchmark(void) {
+  struct tm tm;
+  volatile int sink = 0;
+  const time_t t0 = 1700000000;
+  uint64_t start;
+
+  TEST_ASSERT_TRUE(cal_settz(CET));
+  set_host_tz(CET);
+
+  start = native_nanos();
+  for (time_t t = t0; t < t0 + BENCH_CALLS * 61L; t += 61) {
+    cal_gmtime(t, &tm);
+    sink += tm.tm_mday;
+  }
+  report("cal_gmtime", native_nanos() - start);
+
+  start = native_nanos();
+  for (time_t t = t0; t < t0 + BENCH_CALLS * 61L; t += 61) {
+    gmtime_r(&t, &tm);
+    sink += tm.tm_mday;
+  }
+  report("gmtime_r", native_nanos() - start);
+
+  start = native_nanos();
+  for (time_t t = t0; t < t0 + BENCH_CALLS * 61L; t += 61) {
+    cal_localtime(t, &tm);
+    sink += tm.tm_mday;
+  }
+  report("cal_localtime", native_nanos() - start);
+
+  start = native_nanos();
+  for (time_t t = t0; t < t0 + BENCH_CALLS * 61L; t += 61) {
+    localtime_r(&t, &tm);
+    sink += tm.tm_mday;
+  }
+  report("localtime_r", native_nanos() - start);
+  (void)sink;
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_days_round_trip);
+  RUN_TEST(test_gmtime_against_libc);
+  RUN_TEST(test_gmtime_before_epoch);
+  RUN_TEST(test_localtime_northern);
+  RUN_TEST(test_localtime_southern);
+  RUN_TEST(test_localtime_backwards);
+  RUN_TEST(test_settz_malformed);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
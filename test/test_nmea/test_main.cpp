@@ -0,0 +1,189 @@
+// host tests of src/nmea.cpp, run with "pio test -e native"
+
+#include "../native.h"
+#include "../../src/nmea.cpp"
+#include <unity.h>
+
+// TinyGPS++ is compared in the benchmark only if it is available, see
+// [env:native] in platformio.ini
+#if __has_include(<TinyGPS++.h>)
+#include <TinyGPS++.h>
+#define HAS_TINYGPS
+#endif
+
+#define RMC                                                                    \
+  "$GPRMC,123519.00,A,4807.038,N,01131.000,E,022.4,084.4,230324,003.1,W*4F\r\n"
+#define GGA                                                                    \
+  "$GNGGA,092750.55,5321.6802,N,00630.3372,W,1,08,1.03,61.7,M,55.2,M,,*68\r\n"
+#define RMC_VOID "$GPRMC,235959.5,V,,,,,,,010124,,,N*4F\r\n"
+#define GGA_NOFIX "$GPGGA,000001.00,,,,,0,00,99.99,,,,,,*67\r\n"
+#define GSV                                                                    \
+  "$GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00*74\r\n"
+#define GSA "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39\r\n"
+#define VTG "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\r\n"
+
+static nmeaDecoder_t dec;
+static nmeaFix_t fix;
+
+static void feed(const char *s, uint32_t now_ms = 1000) {
+  nmea_feed(&dec, &fix, s, strlen(s), now_ms);
+}
+
+void setUp(void) {
+  memset(&dec, 0, sizeof(dec));
+  dec.skip = true; // as after start, wait for first '$'
+  memset(&fix, 0, sizeof(fix));
+}
+
+void tearDown(void) {}
+
+void test_rmc(void) {
+  feed(RMC, 1234);
+  TEST_ASSERT_EQUAL_UINT32(1, dec.sentences);
+  TEST_ASSERT_EQUAL_UINT32(0, dec.failed);
+  TEST_ASSERT_EQUAL_INT32(48117300, fix.latitude);
+  TEST_ASSERT_EQUAL_INT32(11516667, fix.longitude);
+  TEST_ASSERT_EQUAL_UINT8(12, fix.hour);
+  TEST_ASSERT_EQUAL_UINT8(35, fix.minute);
+  TEST_ASSERT_EQUAL_UINT8(19, fix.second);
+  TEST_ASSERT_EQUAL_UINT8(0, fix.centisecond);
+  TEST_ASSERT_EQUAL_UINT8(23, fix.day);
+  TEST_ASSERT_EQUAL_UINT8(3, fix.month);
+  TEST_ASSERT_EQUAL_UINT16(2024, fix.year);
+  TEST_ASSERT_EQUAL_UINT32(1234, fix.location_ms);
+  TEST_ASSERT_EQUAL_UINT32(1234, fix.time_ms);
+  TEST_ASSERT_EQUAL_UINT32(1234, fix.date_ms);
+  TEST_ASSERT_EQUAL_UINT32(0, fix.altitude_ms); // not in RMC
+}
+
+void test_gga(void) {
+  feed(GGA, 99);
+  TEST_ASSERT_EQUAL_UINT32(1, dec.sentences);
+  TEST_ASSERT_EQUAL_INT32(53361337, fix.latitude);
+  TEST_ASSERT_EQUAL_INT32(-6505620, fix.longitude);
+  TEST_ASSERT_EQUAL_INT32(6170, fix.altitude);
+  TEST_ASSERT_EQUAL_UINT16(103, fix.hdop);
+  TEST_ASSERT_EQUAL_UINT8(8, fix.satellites);
+  TEST_ASSERT_EQUAL_UINT8(9, fix.hour);
+  TEST_ASSERT_EQUAL_UINT8(55, fix.centisecond);
+  TEST_ASSERT_EQUAL_UINT32(99, fix.location_ms);
+  TEST_ASSERT_EQUAL_UINT32(99, fix.altitude_ms);
+  TEST_ASSERT_EQUAL_UINT32(99, fix.satellites_ms);
+  TEST_ASSERT_EQUAL_UINT32(0, fix.date_ms); // not in GGA
+}
+
+void test_no_fix(void) {
+  // time is valid without a fix, location is not
+  feed(RMC_VOID);
+  feed(GGA_NOFIX);
+  TEST_ASSERT_EQUAL_UINT32(2, dec.sentences);
+  TEST_ASSERT_EQUAL_UINT32(0, fix.location_ms);
+  TEST_ASSERT_EQUAL_UINT32(0, fix.altitude_ms);
+  TEST_ASSERT_EQUAL_UINT8(0, fix.hour);
+  TEST_ASSERT_EQUAL_UINT8(1, fix.second);
+  TEST_ASSERT_EQUAL_UINT16(2024, fix.year);
+  TEST_ASSERT_EQUAL_UINT8(0, fix.satellites);
+  TEST_ASSERT_EQUAL_UINT16(9999, fix.hdop);
+}
+
+void test_checksum_rejected(void) {
+  char s[] = RMC;
+  s[20] = '9'; // latitude digit, checksum now wrong
+  feed(s);
+  TEST_ASSERT_EQUAL_UINT32(0, dec.sentences);
+  TEST_ASSERT_EQUAL_UINT32(1, dec.failed);
+  TEST_ASSERT_EQUAL_UINT32(0, fix.location_ms);
+  TEST_ASSERT_EQUAL_INT32(0, fix.latitude);
+
+  char t[] = GGA;
+  t[strlen(t) - 3] = '9'; // checksum digit
+  feed(t);
+  TEST_ASSERT_EQUAL_UINT32(2, dec.failed);
+  TEST_ASSERT_EQUAL_UINT32(0, fix.time_ms);
+}
+
+void test_other_sentences_skipped(void) {
+  feed(GSV GSA VTG);
+  TEST_ASSERT_EQUAL_UINT32(0, dec.sentences);
+  TEST_ASSERT_EQUAL_UINT32(0, dec.failed);
+  feed(RMC);
+  TEST_ASSERT_EQUAL_UINT32(1, dec.sentences);
+}
+
+void test_split_input(void) {
+  // sentences arrive in arbitrary chunks, starting mid-sentence
+  const char *s = "34.4,M,005.5,N,010.2,K*48\r\n" GGA RMC;
+  for (const char *p = s; *p; p++)
+    nmea_feed(&dec, &fix, p, 1, 1);
+  TEST_ASSERT_EQUAL_UINT32(2, dec.sentences);
+  TEST_ASSERT_EQUAL_UINT32(0, dec.failed);
+  TEST_ASSERT_EQUAL_INT32(48117300, fix.latitude);
+  TEST_ASSERT_EQUAL_INT32(6170, fix.altitude);
+}
+
+void test_garbage(void) {
+  // overlong line, truncated sentence and a restart within a sentence
+  char junk[2 * NMEA_MAXLEN];
+  memset(junk, 'A', sizeof(junk));
+  junk[0] = '$';
+  junk[1] = 'G';
+  junk[2] = 'P';
+  junk[3] = 'R';
+  junk[4] = 'M';
+  junk[5] = 'C';
+  nmea_feed(&dec, &fix, junk, sizeof(junk), 1);
+  feed("\r\n$GPRMC,1235\r\n$GPGGA,0927" GGA);
+  TEST_ASSERT_EQUAL_UINT32(1, dec.sentences);
+  TEST_ASSERT_EQUAL_UINT32(2, dec.failed);
+  TEST_ASSERT_EQUAL_INT32(53361337, fix.latitude);
+}
+
+// --- benchmark, reports ns per byte, no pass/fail ---
+
+#define BENCH_RUNS 100000
+
+// one second of output of a typical receiver
+static const char burst[] = RMC GGA GSA GSV GSV GSV VTG;
+
+void test_benchmark(void) {
+  char msg[80];
+  uint64_t start = native_nanos();
+  for (int i = 0; i < BENCH_RUNS; i++)
+    nmea_feed(&dec, &fix, burst, sizeof(burst) - 1, i);
+  uint64_t ns = native_nanos() - start;
+  TEST_ASSERT_EQUAL_UINT32(2 * BENCH_RUNS, dec.sentences);
+  snprintf(msg, sizeof(msg), "nmea_feed    %5.2f ns/byte, %6.1f ns/burst",
+           (double)ns / BENCH_RUNS / (sizeof(burst) - 1),
+           (double)ns / BENCH_RUNS);
+  TEST_MESSAGE(msg);
+
+#ifdef HAS_TINYGPS
+  TinyGPSPlus gps;
+  start = native_nanos();
+  for (int i = 0; i < BENCH_RUNS; i++)
+    for (const char *p = burst; *p; p++)
+      gps.encode(*p);
+  ns = native_nanos() - start;
+  TEST_ASSERT_INT32_WITHIN(1, fix.latitude,
+                           (int32_t)lround(gps.location.lat() * 1e6));
+  snprintf(msg, sizeof(msg), "TinyGPS++    %5.2f ns/byte, %6.1f ns/burst",
+           (double)ns / BENCH_RUNS / (sizeof(burst) - 1),
+           (double)ns / BENCH_RUNS);
+  TEST_MESSAGE(msg);
+#else
+  TEST_MESSAGE("TinyGPS++ not available, no comparison");
+#endif
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rmc);
+  RUN_TEST(test_gga);
+  RUN_TEST(test_no_fix);
+  RUN_TEST(test_checksum_rejected);
+  RUN_TEST(test_other_sentences_skipped);
+  RUN_TEST(test_split_input);
+  RUN_TEST(test_garbage);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}